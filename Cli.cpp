@@ -2,15 +2,30 @@
 // Created by Joe Chrisman on 4/7/23.
 //
 
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 #include <fstream>
 #include "Cli.h"
 
 Cli::Cli(const Zobrist& zobrist, const Magics& magics)
-: position(zobrist), moveGen(position, magics), evaluator(position, moveGen), search(position, moveGen, evaluator)
+: position(zobrist),
+  moveGen(position, magics),
+  evaluator(position, moveGen),
+  isStopped(false),
+  search(position, moveGen, evaluator, transpositions, isStopped),
+  threads(position, magics, transpositions, isStopped)
 {
     isWhiteOnBottom = true;
+    isInfinite = false;
+    ponderClock = Clock{-1, 0, 0, -1};
+    hasPonderClock = false;
+    search.setHelperNodes(&threads.getHelperNodes());
+}
+
+Cli::~Cli()
+{
+    stopSearch();
 }
 
 int Cli::runCli()
@@ -116,7 +131,7 @@ ____  __.           ))   `\_) .__
                     showReady();
                     continue;
                 }
-                Move best = search.searchByTime(time);
+                Move best = searchByTime(time);
                 std::cout << "~ Best move: " << moveToStr(best) << "\n";
             }
             else if (command.substr(7, 5) == "depth")
@@ -133,9 +148,29 @@ ____  __.           ))   `\_) .__
                     showReady();
                     continue;
                 }
-                ScoredMove best = search.searchByDepth(depth);
-                std::cout << "~ Best move: " << moveToStr(best.move) << "\n";
+                Move best = search.searchToDepth(depth);
+                std::cout << "~ Best move: " << moveToStr(best) << "\n";
+            }
+            showReady();
+        }
+        else if (command.substr(0, 5) == "bench")
+        {
+            int depth = DEFAULT_BENCH_DEPTH;
+            if (command != "bench")
+            {
+                try
+                {
+                    depth = std::stoi(command.substr(6, std::string::npos));
+                }
+                catch (const std::exception& exception)
+                {
+                    std::cout << "~ Unrecognized arguments\n";
+                    std::cout << "~ Run \"help\" for a list of commands\n";
+                    showReady();
+                    continue;
+                }
             }
+            runBench(depth);
             showReady();
         }
         else if (command == "who")
@@ -316,7 +351,15 @@ int Cli::runUci()
     std::cout << std::flush;
     std::cout << "id name Karl\n";
     std::cout << "id author Joe Chrisman\n";
-    std::cout << "uciok\n";
+    std::cout << "option name Hash type spin default " << TranspositionTable::DEFAULT_MEGABYTES;
+    std::cout << " min 1 max " << TranspositionTable::MAX_MEGABYTES << "\n";
+    std::cout << "option name Threads type spin default 1 min 1 max " << SearchThreads::MAX_THREADS << "\n";
+    std::cout << "option name MoveOverhead type spin default " << TimeManager::DEFAULT_MOVE_OVERHEAD;
+    std::cout << " min 0 max " << TimeManager::MAX_MOVE_OVERHEAD << "\n";
+    std::cout << "option name MultiPV type spin default 1 min 1 max " << Search::MAX_MULTI_PV << "\n";
+    std::cout << "option name IIRDepth type spin default " << Search::DEFAULT_IIR_DEPTH;
+    std::cout << " min 0 max " << MAX_DEPTH << "\n";
+    std::cout << "uciok" << std::endl;
 
     std::string command;
     while (std::getline(std::cin, command))
@@ -324,19 +367,33 @@ int Cli::runUci()
         // return to cli mode
         if (command == "exit")
         {
+            stopSearch();
             return 0;
         }
         // kill this entire process
         if (command == "quit")
         {
+            stopSearch();
             return 1;
         }
         else if (command == "isready")
         {
-            std::cout << "readyok\n";
+            std::cout << "readyok" << std::endl;
+        }
+        else if (command.substr(0, 9) == "setoption")
+        {
+            stopSearch();
+            setOption(command);
+        }
+        else if (command == "ucinewgame")
+        {
+            // forget everything from the last game, so a search doesn't depend on what came before it
+            stopSearch();
+            transpositions.clear();
         }
         else if (command.substr(0, 8) == "position")
         {
+            stopSearch();
             size_t movesIndex = command.find("moves");
             if (command.substr(9, 8) == "startpos")
             {
@@ -358,8 +415,9 @@ int Cli::runUci()
                 while (moves >> moveStr)
                 {
                     moveGen.genMoves();
-                    for (const Move move : moveGen.moveList)
+                    for (int i = 0; i < moveGen.numMoves; i++)
                     {
+                        const Move move = moveGen.moveList[i];
                         if (moveStr == moveToStr(move))
                         {
                             position.makeMove(move);
@@ -371,41 +429,295 @@ int Cli::runUci()
         }
         else if (command.substr(0, 2) == "go")
         {
-            Move best;
+            startSearch(command);
+        }
+        else if (command == "stop")
+        {
+            stopSearch();
+        }
+        else if (command == "ponderhit")
+        {
+            // the opponent played the move we were pondering on, so start using our clock
+            if (hasPonderClock)
+            {
+                startClock(ponderClock);
+                hasPonderClock = false;
+                isInfinite = false;
+            }
+        }
+    }
+    stopSearch();
+    return 0;
+}
+
+void Cli::startSearch(const std::string& command)
+{
+    // never let two searches run on the same position
+    stopSearch();
+
+    std::stringstream stream(command);
+    std::string token;
+    Clock clock{-1, 0, 0, -1};
+    int maxDepth = 0;
+    U64 maxNodes = 0;
+    bool isPonder = false;
+    bool isInfiniteSearch = false;
+
+    stream >> token; // skip "go"
+    while (stream >> token)
+    {
+        if (token == "infinite")
+        {
+            isInfiniteSearch = true;
+        }
+        else if (token == "ponder")
+        {
+            isPonder = true;
+        }
+        else if (token == "movetime")
+        {
+            stream >> clock.msMoveTime;
+            clock.msMoveTime = std::max(clock.msMoveTime, 0);
+        }
+        else if (token == (position.isWhiteToMove ? "wtime" : "btime"))
+        {
+            // some GUIs send a negative time once we have overstepped it. we are still on the clock, with nothing left
+            stream >> clock.msRemaining;
+            clock.msRemaining = std::max(clock.msRemaining, 0);
+        }
+        else if (token == (position.isWhiteToMove ? "winc" : "binc"))
+        {
+            stream >> clock.msIncrement;
+        }
+        else if (token == "movestogo")
+        {
+            stream >> clock.movesToGo;
+        }
+        else if (token == "depth")
+        {
+            stream >> maxDepth;
+        }
+        else if (token == "nodes")
+        {
+            stream >> maxNodes;
+        }
+    }
+    search.setSearchLimits(maxDepth, maxNodes);
+    const bool isLimited = isTimed(clock) || maxDepth > 0 || maxNodes > 0;
+
+    // a ponder search runs without a clock until the ponderhit arrives
+    ponderClock = clock;
+    hasPonderClock = isPonder && !isInfiniteSearch && isLimited;
+    isInfinite = isInfiniteSearch || isPonder || !isLimited;
+    if (isInfinite)
+    {
+        search.clearTimeLimit();
+    }
+    else
+    {
+        startClock(clock);
+    }
+
+    transpositions.age();
+    threads.startHelpers();
+    searchThread = std::thread([this]()
+    {
+        const Move best = search.searchUntilStopped();
+
+        // in infinite and ponder mode we must not report a move until we are told to
+        while (isInfinite && !isStopped)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        threads.stopHelpers();
+
+        // with no legal moves, UCI wants a null move. otherwise the reply comes from the principal variation,
+        // so the GUI can ponder on it
+        const Move ponder = search.getPonderMove();
+        std::cout << "bestmove " << (best == NULL_MOVE ? "0000" : moveToStr(best));
+        if (best != NULL_MOVE && ponder != NULL_MOVE)
+        {
+            std::cout << " ponder " << moveToStr(ponder);
+        }
+        std::cout << std::endl;
+    });
+}
+
+bool Cli::isTimed(const Clock& clock)
+{
+    return clock.msMoveTime >= 0 || clock.msRemaining >= 0;
+}
+
+void Cli::startClock(const Clock& clock)
+{
+    if (clock.msMoveTime >= 0)
+    {
+        search.setTimeLimit(clock.msMoveTime);
+    }
+    else if (clock.msRemaining >= 0)
+    {
+        search.setTimeControl(clock.msRemaining, clock.msIncrement, clock.movesToGo);
+    }
+    else
+    {
+        search.clearTimeLimit();
+    }
+}
+
+void Cli::stopSearch()
+{
+    if (searchThread.joinable())
+    {
+        isInfinite = false;
+        isStopped = true;
+        searchThread.join();
 
-            if (command.substr(0, 11) == "go movetime")
+        // the CLI searches share the flag, and would stop right away if we left it raised
+        isStopped = false;
+    }
+}
+
+void Cli::setOption(const std::string& command)
+{
+    std::stringstream stream(command);
+    std::string name;
+    std::string value;
+    std::string consume; // get rid of "setoption name" and "value"
+    stream >> consume >> consume >> name >> consume >> value;
+
+    if (name == "Hash")
+    {
+        try
+        {
+            const int megabytes = std::stoi(value);
+            if (megabytes < 1 || megabytes > TranspositionTable::MAX_MEGABYTES)
             {
-                int time = std::stoi(command.substr(12, std::string::npos));
-                best = search.searchByTime(time);
+                std::cout << "info string Hash must be between 1 and " << TranspositionTable::MAX_MEGABYTES << "\n";
+                return;
             }
-            else
+            transpositions.resize(megabytes);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "info string Failed to set Hash to \"" << value << "\"\n";
+        }
+    }
+    else if (name == "Threads")
+    {
+        try
+        {
+            const int numThreads = std::stoi(value);
+            if (numThreads < 1 || numThreads > SearchThreads::MAX_THREADS)
             {
-                std::stringstream timeControls(command.substr(2, std::string::npos));
-                int msRemaining = 0;
-                int msIncrement = 0;
-                std::string consume; // get rid of flags sent in the command
-                if (position.isWhiteToMove)
-                {
-                    timeControls >> consume >> msRemaining;
-                    timeControls >> consume >> consume;
-                    timeControls >> consume >> msIncrement;
-                    timeControls >> consume >> consume;
-                }
-                else
-                {
-                    timeControls >> consume >> consume;
-                    timeControls >> consume >> msRemaining;
-                    timeControls >> consume >> consume;
-                    timeControls >> consume >> msIncrement;
-                }
-
-                best = search.searchByTimeControl(msRemaining, msIncrement);
+                std::cout << "info string Threads must be between 1 and " << SearchThreads::MAX_THREADS << "\n";
+                return;
             }
-
-            std::cout << "bestmove " << moveToStr(best) << "\n";
+            threads.setNumThreads(numThreads);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "info string Failed to set Threads to \"" << value << "\"\n";
         }
     }
-    return 0;
+    else if (name == "MoveOverhead")
+    {
+        try
+        {
+            const int msOverhead = std::stoi(value);
+            if (msOverhead < 0 || msOverhead > TimeManager::MAX_MOVE_OVERHEAD)
+            {
+                std::cout << "info string MoveOverhead must be between 0 and " << TimeManager::MAX_MOVE_OVERHEAD << "\n";
+                return;
+            }
+            search.setMoveOverhead(msOverhead);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "info string Failed to set MoveOverhead to \"" << value << "\"\n";
+        }
+    }
+    else if (name == "MultiPV")
+    {
+        try
+        {
+            const int numLines = std::stoi(value);
+            if (numLines < 1 || numLines > Search::MAX_MULTI_PV)
+            {
+                std::cout << "info string MultiPV must be between 1 and " << Search::MAX_MULTI_PV << "\n";
+                return;
+            }
+            search.setMultiPv(numLines);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "info string Failed to set MultiPV to \"" << value << "\"\n";
+        }
+    }
+    else if (name == "IIRDepth")
+    {
+        try
+        {
+            const int depth = std::stoi(value);
+            if (depth < 0 || depth > MAX_DEPTH)
+            {
+                std::cout << "info string IIRDepth must be between 0 and " << MAX_DEPTH << "\n";
+                return;
+            }
+            search.setIirDepth(depth);
+            threads.setIirDepth(depth);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "info string Failed to set IIRDepth to \"" << value << "\"\n";
+        }
+    }
+    else
+    {
+        std::cout << "info string Unrecognized option \"" << name << "\"\n";
+    }
+}
+
+Move Cli::searchByTime(const int msTargetElapsed)
+{
+    // age the table before any thread can touch it
+    transpositions.age();
+    threads.startHelpers();
+    const Move best = search.searchByTime(msTargetElapsed);
+    threads.stopHelpers();
+    return best;
+}
+
+void Cli::runBench(const int depth)
+{
+    static const std::string BENCH_POSITIONS[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R1BQKB1R w KQ - 0 1"
+    };
+
+    const Position before = position;
+    U64 totalNodes = 0;
+    const long startTime = getMonotonicMillis();
+    for (const std::string& fen : BENCH_POSITIONS)
+    {
+        position.loadFen(fen);
+        transpositions.clear();
+        search.searchToDepth(depth);
+        totalNodes += search.getTotalNodes();
+    }
+    const long msElapsed = std::max(getMonotonicMillis() - startTime, 1L);
+    position = before;
+
+    std::cout << "~ Depth " << depth << " bench results\n";
+    std::cout << "\t~ =========================\n";
+    std::cout << "\t~ Positions   | " << std::size(BENCH_POSITIONS) << "\n";
+    std::cout << "\t~ Time        | " << msElapsed << "ms\n";
+    std::cout << "\t~ Nodes       | " << totalNodes << "\n";
+    std::cout << "\t~ kN/s        | " << totalNodes / msElapsed << "\n";
+    std::cout << "\t~ =========================\n";
 }
 
 void Cli::printPerftInfo(const PerftInfo& info, const int depth, const double msElapsed)
@@ -5,7 +5,7 @@
 #ifndef KARL_CLI_H
 #define KARL_CLI_H
 
-#include "Search.h"
+#include "SearchThreads.h"
 #include "Notation.h"
 
 class Cli
@@ -13,6 +13,7 @@ class Cli
 
 public:
     Cli(const Zobrist& zobrist, const Magics& magics);
+    ~Cli();
     int runCli();
 
 private:
@@ -20,8 +21,11 @@ private:
 
     Evaluator evaluator;
     Position position;
+    TranspositionTable transpositions;
+    std::atomic<bool> isStopped;
     Search search;
     MoveGen moveGen;
+    SearchThreads threads;
 
     struct PerftInfo
     {
@@ -37,6 +41,35 @@ private:
 
     void showReady();
     int runUci();
+    void setOption(const std::string& command);
+    Move searchByTime(const int msTargetElapsed);
+
+    // the time limits from a "go" command. -1 means the limit wasn't given
+    struct Clock
+    {
+        int msRemaining;
+        int msIncrement;
+        int movesToGo;
+        int msMoveTime;
+    };
+
+    // the UCI search runs on its own thread, so we can still read commands while thinking
+    std::thread searchThread;
+    std::atomic<bool> isInfinite;
+
+    // a ponder search keeps its clock until the ponderhit arrives
+    Clock ponderClock;
+    bool hasPonderClock;
+
+    bool isTimed(const Clock& clock);
+    void startClock(const Clock& clock);
+
+    void startSearch(const std::string& command);
+    void stopSearch();
+
+    // search a few fixed positions to a fixed depth, to measure the search speed
+    static constexpr int DEFAULT_BENCH_DEPTH = 12;
+    void runBench(const int depth);
 
     void runPerftSuite();
     void perft(int depth, PerftInfo &info, int splitDepth = -1);
@@ -8,6 +8,9 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <climits>
+#include <cstring>
 #include <x86intrin.h>
 
 typedef unsigned long long U64;
@@ -116,7 +119,7 @@ inline Square getSquare(const int rank, const int file)
 
 inline Square getSquare(const U64 board)
 {
-    return (Square)_mm_tzcnt_64(board);
+    return (Square)__builtin_ctzll(board);
 }
 
 inline Square popFirstPiece(U64& board)
@@ -228,10 +231,11 @@ Square northWest(const Square square)
     return square - 9 * distance;
 }
 
-inline long getEpochMillis()
+// milliseconds since some fixed point, which never jumps when the wall clock is adjusted
+inline long getMonotonicMillis()
 {
     return duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+            std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 inline void printBitboard(const U64 board)
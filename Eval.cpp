@@ -11,6 +11,16 @@ Evaluator::Evaluator(Position& position, MoveGen& moveGen) :
     std::memset(pawnStructures, 0, sizeof(pawnStructures));
 }
 
+int Evaluator::getPawnStructureKey() const
+{
+    return (position.bitboards[WHITE_PAWN] | position.bitboards[BLACK_PAWN]) % NUM_PAWN_STRUCTURES;
+}
+
+void Evaluator::prefetch() const
+{
+    __builtin_prefetch(&pawnStructures[getPawnStructureKey()]);
+}
+
 Score Evaluator::evaluate()
 {
     Score whiteAdvantage = position.materialScore + position.placementScore;
@@ -30,8 +40,7 @@ Score Evaluator::evaluate()
     const U64 whitePawns = position.bitboards[WHITE_PAWN];
     const U64 blackPawns = position.bitboards[BLACK_PAWN];
 
-    const Hash pawnStructureKey = (whitePawns | blackPawns) % NUM_PAWN_STRUCTURES;
-    PawnStructure& pawnStructure = pawnStructures[pawnStructureKey];
+    PawnStructure& pawnStructure = pawnStructures[getPawnStructureKey()];
     if (pawnStructure.whitePawns != whitePawns ||
         pawnStructure.blackPawns != blackPawns)
     {
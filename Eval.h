@@ -14,9 +14,10 @@ class Position;
 class MoveGen;
 
 typedef int Score;
-inline constexpr Score TIMEOUT = INT_MIN;
 inline constexpr Score MAX_SCORE = 30000;
 inline constexpr Score MIN_SCORE = -30000;
+// returned by a search that was stopped. it is below every real score, but can still be negated by the parent
+inline constexpr Score TIMEOUT = MIN_SCORE - 2;
 inline constexpr Score CONTEMPT = 250;
 
 class Evaluator
@@ -25,6 +26,9 @@ public:
     Evaluator(Position& position, MoveGen& gen);
     Score evaluate();
 
+    // start loading the cached pawn structure of the current position, before we evaluate it
+    void prefetch() const;
+
 private:
     Position& position;
     MoveGen& moveGen;
@@ -44,6 +48,8 @@ private:
     static constexpr int NUM_PAWN_STRUCTURES = 8192;
     PawnStructure pawnStructures[NUM_PAWN_STRUCTURES];
 
+    inline int getPawnStructureKey() const;
+
     static constexpr Score ISOLATED_PAWN_PENALTY = -20;
     static constexpr Score DOUBLED_PAWN_PENALTY = -10;
 
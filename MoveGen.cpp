@@ -2,6 +2,7 @@
 // Created by Joe Chrisman on 4/6/23.
 //
 
+#include <algorithm>
 #include "MoveGen.h"
 
 
@@ -17,6 +18,7 @@ MoveGen::MoveGen(Position& position, const Magics& magics)
     safeSquares = EMPTY_BOARD;
     cardinalPins = EMPTY_BOARD;
     ordinalPins = EMPTY_BOARD;
+    legalityHash = 0;
 }
 
 void MoveGen::initKnightMoves()
@@ -116,17 +118,23 @@ void MoveGen::initKingMoves()
 
 template<bool isCardinal>
 U64 MoveGen::getSlidingMoves(Square from)
+{
+    return getSlidingMoves<isCardinal>(from, position.occupiedSquares);
+}
+
+template<bool isCardinal>
+U64 MoveGen::getSlidingMoves(Square from, U64 occupied)
 {
     if constexpr (isCardinal)
     {
         const MagicSquare square = magics.cardinalMagics[from];
-        U64 blockers = square.blockers & position.occupiedSquares;
+        U64 blockers = square.blockers & occupied;
         return magics.cardinalAttacks[from][blockers * square.magic >> 52];
     }
     else
     {
         const MagicSquare square = magics.ordinalMagics[from];
-        U64 blockers = square.blockers & position.occupiedSquares;
+        U64 blockers = square.blockers & occupied;
         return magics.ordinalAttacks[from][blockers * square.magic >> 55];
     }
 }
@@ -205,7 +213,24 @@ U64 MoveGen::getPawnCaptures(const U64 pawns)
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
+U64 MoveGen::getTargets()
+{
+    if constexpr (type == GEN_CAPTURES)
+    {
+        return isWhite ? position.blackPieces : position.whitePieces;
+    }
+    else if constexpr (type == GEN_QUIETS)
+    {
+        return position.emptySquares;
+    }
+    else
+    {
+        return isWhite ? position.blackOrEmpty : position.whiteOrEmpty;
+    }
+}
+
+template<bool isWhite, GenType type>
 void MoveGen::genPawnMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_PAWN : BLACK_PAWN;
@@ -217,100 +242,103 @@ void MoveGen::genPawnMoves()
     const U64 cardinalPinnedPawns = pawns & cardinalPins;
     const U64 ordinalPinnedPawns = pawns & ordinalPins;
 
-    const U64 unpinnedEastCaptures = getPawnCaptures<isWhite, true>(unpinnedPawns);
-    const U64 unpinnedWestCaptures = getPawnCaptures<isWhite, false>(unpinnedPawns);
-    const U64 pinnedEastCaptures = getPawnCaptures<isWhite, true>(ordinalPinnedPawns) & ordinalPins;
-    const U64 pinnedWestCaptures = getPawnCaptures<isWhite, false>(ordinalPinnedPawns) & ordinalPins;
-
-    U64 eastCaptures = unpinnedEastCaptures | pinnedEastCaptures;
-    U64 westCaptures = unpinnedWestCaptures | pinnedWestCaptures;
-
     const U64 unpinnedPawnPushes = (isWhite ? north(unpinnedPawns) : south(unpinnedPawns)) & position.emptySquares;
 
-    // calculate pawn promotions
-    if (pawns & beforePromotionRank)
+    if constexpr (type != GEN_QUIETS)
     {
-        U64 eastCapturePromotions = eastCaptures & promotionRank;
-        U64 westCapturePromotions = westCaptures & promotionRank;
+        const U64 unpinnedEastCaptures = getPawnCaptures<isWhite, true>(unpinnedPawns);
+        const U64 unpinnedWestCaptures = getPawnCaptures<isWhite, false>(unpinnedPawns);
+        const U64 pinnedEastCaptures = getPawnCaptures<isWhite, true>(ordinalPinnedPawns) & ordinalPins;
+        const U64 pinnedWestCaptures = getPawnCaptures<isWhite, false>(ordinalPinnedPawns) & ordinalPins;
+
+        U64 eastCaptures = unpinnedEastCaptures | pinnedEastCaptures;
+        U64 westCaptures = unpinnedWestCaptures | pinnedWestCaptures;
 
-        while (eastCapturePromotions)
+        // calculate pawn promotions
+        if (pawns & beforePromotionRank)
         {
-            const Square to = popFirstPiece(eastCapturePromotions);
-            const Square from = isWhite ? southWest(to) : northWest(to);
-            genPromotions<isWhite>(from, to, position.pieces[to]);
+            U64 eastCapturePromotions = eastCaptures & promotionRank;
+            U64 westCapturePromotions = westCaptures & promotionRank;
+
+            while (eastCapturePromotions)
+            {
+                const Square to = popFirstPiece(eastCapturePromotions);
+                const Square from = isWhite ? southWest(to) : northWest(to);
+                genPromotions<isWhite>(from, to, position.pieces[to]);
+            }
+            while (westCapturePromotions)
+            {
+                const Square to = popFirstPiece(westCapturePromotions);
+                const Square from = isWhite ? southEast(to) : northEast(to);
+                genPromotions<isWhite>(from, to, position.pieces[to]);
+            }
+            U64 pushPromotions = unpinnedPawnPushes & promotionRank & resolverSquares;
+            while (pushPromotions)
+            {
+                const Square to = popFirstPiece(pushPromotions);
+                const Square from = isWhite ? south(to) : north(to);
+                genPromotions<isWhite>(from, to, NULL_PIECE);
+            }
         }
-        while (westCapturePromotions)
+        westCaptures &= ~promotionRank;
+        eastCaptures &= ~promotionRank;
+        while (eastCaptures)
         {
-            const Square to = popFirstPiece(westCapturePromotions);
-            const Square from = isWhite ? southEast(to) : northEast(to);
-            genPromotions<isWhite>(from, to, position.pieces[to]);
+            const Square to = popFirstPiece(eastCaptures);
+            const Square from = isWhite ? southWest(to) : northWest(to);
+            moveList[numMoves++] = createMove(from, to, pieceMoving, position.pieces[to]);
         }
-        U64 pushPromotions = unpinnedPawnPushes & promotionRank & resolverSquares;
-        while (pushPromotions)
+        while (westCaptures)
         {
-            const Square to = popFirstPiece(pushPromotions);
-            const Square from = isWhite ? south(to) : north(to);
-            genPromotions<isWhite>(from, to, NULL_PIECE);
+            const Square to = popFirstPiece(westCaptures);
+            const Square from = isWhite ? southEast(to) : northEast(to);
+            moveList[numMoves++] = createMove(from, to, pieceMoving, position.pieces[to]);
         }
-    }
-    westCaptures &= ~promotionRank;
-    eastCaptures &= ~promotionRank;
-    while (eastCaptures)
-    {
-        const Square to = popFirstPiece(eastCaptures);
-        const Square from = isWhite ? southWest(to) : northWest(to);
-        moveList[numMoves++] = createMove(from, to, pieceMoving, position.pieces[to]);
-    }
-    while (westCaptures)
-    {
-        const Square to = popFirstPiece(westCaptures);
-        const Square from = isWhite ? southEast(to) : northEast(to);
-        moveList[numMoves++] = createMove(from, to, pieceMoving, position.pieces[to]);
-    }
 
-    const int enPassantFile = position.irreversibles.enPassantFile;
-    if (enPassantFile > -1)
-    {
-        static constexpr U64 eastCaptureMask = ~FILES[A_FILE];
-        static constexpr U64 westCaptureMask = ~FILES[H_FILE];
-        static constexpr Piece pawnCapturing = isWhite ? BLACK_PAWN : WHITE_PAWN;
+        const int enPassantFile = position.irreversibles.enPassantFile;
+        if (enPassantFile > -1)
+        {
+            static constexpr U64 eastCaptureMask = ~FILES[A_FILE];
+            static constexpr U64 westCaptureMask = ~FILES[H_FILE];
+            static constexpr Piece pawnCapturing = isWhite ? BLACK_PAWN : WHITE_PAWN;
 
-        const U64 enPassantSquare = FILES[position.irreversibles.enPassantFile] &
-                                    RANKS[isWhite ? SIXTH_RANK : THIRD_RANK];
-        const U64 shiftedResolvers = isWhite ? north(resolverSquares) : south(resolverSquares);
-        const U64 enPassantMask = enPassantSquare & shiftedResolvers;
+            const U64 enPassantSquare = FILES[position.irreversibles.enPassantFile] &
+                                        RANKS[isWhite ? SIXTH_RANK : THIRD_RANK];
+            const U64 shiftedResolvers = isWhite ? north(resolverSquares) : south(resolverSquares);
+            const U64 enPassantMask = enPassantSquare & shiftedResolvers;
 
-        const U64 unpinnedWestCapture = isWhite ? northWest(unpinnedPawns) : southWest(unpinnedPawns);
-        const U64 unpinnedEastCapture = isWhite ? northEast(unpinnedPawns) : southEast(unpinnedPawns);
+            const U64 unpinnedWestCapture = isWhite ? northWest(unpinnedPawns) : southWest(unpinnedPawns);
+            const U64 unpinnedEastCapture = isWhite ? northEast(unpinnedPawns) : southEast(unpinnedPawns);
 
-        const U64 pinnedWestCapture = (isWhite ? northWest(ordinalPinnedPawns) : southWest(ordinalPinnedPawns))
-                & ordinalPins;
-        const U64 pinnedEastCapture = (isWhite ? northEast(ordinalPinnedPawns) : southEast(ordinalPinnedPawns))
-                & ordinalPins;
+            const U64 pinnedWestCapture = (isWhite ? northWest(ordinalPinnedPawns) : southWest(ordinalPinnedPawns))
+                    & ordinalPins;
+            const U64 pinnedEastCapture = (isWhite ? northEast(ordinalPinnedPawns) : southEast(ordinalPinnedPawns))
+                    & ordinalPins;
 
-        U64 westCapture = (unpinnedWestCapture | pinnedWestCapture) & enPassantMask & westCaptureMask;
-        U64 eastCapture = (unpinnedEastCapture | pinnedEastCapture) & enPassantMask & eastCaptureMask;
+            U64 westCapture = (unpinnedWestCapture | pinnedWestCapture) & enPassantMask & westCaptureMask;
+            U64 eastCapture = (unpinnedEastCapture | pinnedEastCapture) & enPassantMask & eastCaptureMask;
 
-        if (eastCapture)
-        {
-            const Square to = getSquare(eastCapture);
-            const Square from = isWhite ? southWest(to) : northWest(to);
-            if (!isEnPassantHorizontallyPinned<isWhite>(from, to))
+            if (eastCapture)
             {
-                moveList[numMoves++] = EN_PASSANT | createMove(from, to, pieceMoving, pawnCapturing);
+                const Square to = getSquare(eastCapture);
+                const Square from = isWhite ? southWest(to) : northWest(to);
+                if (!isEnPassantHorizontallyPinned<isWhite>(from, to))
+                {
+                    moveList[numMoves++] = EN_PASSANT | createMove(from, to, pieceMoving, pawnCapturing);
+                }
             }
-        }
-        if (westCapture)
-        {
-            const Square to = getSquare(westCapture);
-            const Square from = isWhite ? southEast(to) : northEast(to);
-            if (!isEnPassantHorizontallyPinned<isWhite>(from, to))
+            if (westCapture)
             {
-                moveList[numMoves++] = EN_PASSANT | createMove(from, to, pieceMoving, pawnCapturing);
+                const Square to = getSquare(westCapture);
+                const Square from = isWhite ? southEast(to) : northEast(to);
+                if (!isEnPassantHorizontallyPinned<isWhite>(from, to))
+                {
+                    moveList[numMoves++] = EN_PASSANT | createMove(from, to, pieceMoving, pawnCapturing);
+                }
             }
         }
     }
-    if constexpr (quiets)
+    if constexpr (type != GEN_CAPTURES)
     {
         const U64 pinnedPawnPushes = (isWhite ? north(cardinalPinnedPawns) : south(cardinalPinnedPawns))
              & position.emptySquares
@@ -339,7 +367,7 @@ void MoveGen::genPawnMoves()
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
 void MoveGen::genKnightMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_KNIGHT : BLACK_KNIGHT;
@@ -351,14 +379,7 @@ void MoveGen::genKnightMoves()
     {
         Square from = popFirstPiece(knights);
         U64 moves = knightMoves[from];
-        if constexpr (quiets)
-        {
-            moves &= (isWhite ? position.blackOrEmpty : position.whiteOrEmpty);
-        }
-        else
-        {
-            moves &= (isWhite ? position.blackPieces : position.whitePieces);
-        }
+        moves &= getTargets<isWhite, type>();
         moves &= resolverSquares;
         while (moves)
         {
@@ -368,7 +389,7 @@ void MoveGen::genKnightMoves()
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
 void MoveGen::genBishopMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_BISHOP : BLACK_BISHOP;
@@ -378,14 +399,7 @@ void MoveGen::genBishopMoves()
     {
         const Square from = popFirstPiece(bishops);
         U64 moves = getSlidingMoves<false>(from);
-        if constexpr (quiets)
-        {
-            moves &= isWhite ? position.blackOrEmpty : position.whiteOrEmpty;
-        }
-        else
-        {
-            moves &= isWhite ? position.blackPieces : position.whitePieces;
-        }
+        moves &= getTargets<isWhite, type>();
         moves &= resolverSquares;
         if (getBoard(from) & ordinalPins)
         {
@@ -399,7 +413,7 @@ void MoveGen::genBishopMoves()
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
 void MoveGen::genRookMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_ROOK : BLACK_ROOK;
@@ -409,14 +423,7 @@ void MoveGen::genRookMoves()
     {
         const Square from = popFirstPiece(rooks);
         U64 moves = getSlidingMoves<true>(from);
-        if constexpr (quiets)
-        {
-            moves &= isWhite ? position.blackOrEmpty : position.whiteOrEmpty;
-        }
-        else
-        {
-            moves &= isWhite ? position.blackPieces : position.whitePieces;
-        }
+        moves &= getTargets<isWhite, type>();
         moves &= resolverSquares;
         if (getBoard(from) & cardinalPins)
         {
@@ -430,7 +437,7 @@ void MoveGen::genRookMoves()
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
 void MoveGen::genQueenMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_QUEEN : BLACK_QUEEN;
@@ -456,14 +463,7 @@ void MoveGen::genQueenMoves()
                 moves &= cardinalPins;
             }
         }
-        if constexpr (quiets)
-        {
-            moves &= isWhite ? position.blackOrEmpty : position.whiteOrEmpty;
-        }
-        else
-        {
-            moves &= isWhite ? position.blackPieces : position.whitePieces;
-        }
+        moves &= getTargets<isWhite, type>();
         moves &= resolverSquares;
         while (moves)
         {
@@ -473,28 +473,21 @@ void MoveGen::genQueenMoves()
     }
 }
 
-template<bool isWhite, bool quiets>
+template<bool isWhite, GenType type>
 void MoveGen::genKingMoves()
 {
     static constexpr Piece pieceMoving = isWhite ? WHITE_KING : BLACK_KING;
 
     const Square from = getSquare(position.bitboards[pieceMoving]);
     U64 moves = kingMoves[from] & safeSquares;
-    if constexpr (quiets)
-    {
-        moves &= (isWhite ? position.blackOrEmpty : position.whiteOrEmpty);
-    }
-    else
-    {
-        moves &= (isWhite ? position.blackPieces : position.whitePieces);
-    }
+    moves &= getTargets<isWhite, type>();
     while (moves)
     {
         const Square to = popFirstPiece(moves);
         moveList[numMoves++] = createMove(from, to, pieceMoving, position.pieces[to]);
     }
 
-    if constexpr (quiets)
+    if constexpr (type != GEN_CAPTURES)
     {
         static constexpr int castleShort = isWhite ? WHITE_CASTLE_SHORT : BLACK_CASTLE_SHORT;
         static constexpr int castleLong = isWhite ? WHITE_CASTLE_LONG : BLACK_CASTLE_LONG;
@@ -686,41 +679,98 @@ bool MoveGen::isInCheck()
     attackers |= knightMoves[kingSquare] & position.bitboards[isWhite ? BLACK_KNIGHT : WHITE_KNIGHT];
 
     const U64 pawnAttackRank = isWhite ? north(king) : south(king);
-    U64 pawnAttacks = (east(pawnAttackRank) & ~FILES[A_FILE]) | (west(pawnAttackRank) & ~FILES[A_FILE]);
+    U64 pawnAttacks = (east(pawnAttackRank) & ~FILES[A_FILE]) | (west(pawnAttackRank) & ~FILES[H_FILE]);
     pawnAttacks &= position.bitboards[isWhite ? BLACK_PAWN : WHITE_PAWN];
     attackers |= pawnAttacks;
     return static_cast<bool>(attackers);
 }
 
-// generate fully legal moves
-template<bool isWhite, bool quiets>
-void MoveGen::genLegalMoves()
+template<bool isWhite>
+void MoveGen::updateLegality()
 {
-    numMoves = 0;
-
-    std::memset(moveList, NULL_MOVE, sizeof(moveList));
+    // the move picker asks for moves from the same position several times, with other positions in between.
+    // the squares and pins only depend on the position, so don't calculate them again if nothing changed
+    if (position.hash == legalityHash)
+    {
+        return;
+    }
     updateSafeSquares<isWhite>();
     updateResolverSquares<isWhite>();
     updatePins<isWhite, true>();
     updatePins<isWhite, false>();
+    legalityHash = position.hash;
+}
 
-    genPawnMoves<isWhite, quiets>();
-    genKnightMoves<isWhite, quiets>();
-    genKingMoves<isWhite, quiets>();
-    genRookMoves<isWhite, quiets>();
-    genBishopMoves<isWhite, quiets>();
-    genQueenMoves<isWhite, quiets>();
+// generate fully legal moves
+template<bool isWhite, GenType type>
+void MoveGen::genLegalMoves()
+{
+    numMoves = 0;
+
+    updateLegality<isWhite>();
+
+    genPawnMoves<isWhite, type>();
+    genKnightMoves<isWhite, type>();
+    genKingMoves<isWhite, type>();
+    genRookMoves<isWhite, type>();
+    genBishopMoves<isWhite, type>();
+    genQueenMoves<isWhite, type>();
+}
+
+template<bool isWhite>
+bool MoveGen::isLegal(const Move move)
+{
+    const Piece moved = getMoved(move);
+    if (move == NULL_MOVE || position.pieces[getFrom(move)] != moved)
+    {
+        return false;
+    }
+    if (!(move & EN_PASSANT) && position.pieces[getTo(move)] != getCaptured(move))
+    {
+        return false;
+    }
+
+    // only generate the moves of the piece type that moved
+    numMoves = 0;
+    updateLegality<isWhite>();
+    switch (moved)
+    {
+        case WHITE_PAWN:
+        case BLACK_PAWN:
+            genPawnMoves<isWhite, GEN_ALL>();
+            break;
+        case WHITE_KNIGHT:
+        case BLACK_KNIGHT:
+            genKnightMoves<isWhite, GEN_ALL>();
+            break;
+        case WHITE_BISHOP:
+        case BLACK_BISHOP:
+            genBishopMoves<isWhite, GEN_ALL>();
+            break;
+        case WHITE_ROOK:
+        case BLACK_ROOK:
+            genRookMoves<isWhite, GEN_ALL>();
+            break;
+        case WHITE_QUEEN:
+        case BLACK_QUEEN:
+            genQueenMoves<isWhite, GEN_ALL>();
+            break;
+        default:
+            genKingMoves<isWhite, GEN_ALL>();
+            break;
+    }
+    return std::find(moveList, moveList + numMoves, move) != moveList + numMoves;
 }
 
 void MoveGen::genMoves()
 {
     if (position.isWhiteToMove)
     {
-        genLegalMoves<true, true>();
+        genLegalMoves<true, GEN_ALL>();
     }
     else
     {
-        genLegalMoves<false, true>();
+        genLegalMoves<false, GEN_ALL>();
     }
 }
 
@@ -728,15 +778,126 @@ void MoveGen::genCaptures()
 {
     if (position.isWhiteToMove)
     {
-        genLegalMoves<true, false>();
+        genLegalMoves<true, GEN_CAPTURES>();
     }
     else
     {
-        genLegalMoves<false, false>();
+        genLegalMoves<false, GEN_CAPTURES>();
     }
 }
 
+U64 MoveGen::getAttackersTo(const Square square, const U64 occupied)
+{
+    const U64 target = getBoard(square);
+    const U64 whitePawnAttackers = (southEast(target) & ~FILES[A_FILE]) | (southWest(target) & ~FILES[H_FILE]);
+    const U64 blackPawnAttackers = (northEast(target) & ~FILES[A_FILE]) | (northWest(target) & ~FILES[H_FILE]);
+
+    const U64 cardinalAttackers = position.bitboards[WHITE_ROOK] | position.bitboards[BLACK_ROOK]
+        | position.bitboards[WHITE_QUEEN] | position.bitboards[BLACK_QUEEN];
+    const U64 ordinalAttackers = position.bitboards[WHITE_BISHOP] | position.bitboards[BLACK_BISHOP]
+        | position.bitboards[WHITE_QUEEN] | position.bitboards[BLACK_QUEEN];
+
+    U64 attackers = EMPTY_BOARD;
+    attackers |= whitePawnAttackers & position.bitboards[WHITE_PAWN];
+    attackers |= blackPawnAttackers & position.bitboards[BLACK_PAWN];
+    attackers |= knightMoves[square] & (position.bitboards[WHITE_KNIGHT] | position.bitboards[BLACK_KNIGHT]);
+    attackers |= kingMoves[square] & (position.bitboards[WHITE_KING] | position.bitboards[BLACK_KING]);
+    attackers |= getSlidingMoves<true>(square, occupied) & cardinalAttackers;
+    attackers |= getSlidingMoves<false>(square, occupied) & ordinalAttackers;
+    return attackers & occupied;
+}
+
+int MoveGen::getExchangeScore(const Move move)
+{
+    // how much each piece is worth in an exchange. the king can never be captured, so it is worth the most
+    static constexpr int exchangeScores[13] = {
+        0, 100, 310, 380, 500, 940, 20000, 100, 310, 380, 500, 940, 20000
+    };
+
+    const Square from = getFrom(move);
+    const Square to = getTo(move);
+    const Piece promoted = getPromoted(move);
+
+    const U64 cardinalAttackers = position.bitboards[WHITE_ROOK] | position.bitboards[BLACK_ROOK]
+        | position.bitboards[WHITE_QUEEN] | position.bitboards[BLACK_QUEEN];
+    const U64 ordinalAttackers = position.bitboards[WHITE_BISHOP] | position.bitboards[BLACK_BISHOP]
+        | position.bitboards[WHITE_QUEEN] | position.bitboards[BLACK_QUEEN];
+
+    // gains[n] is the material won by the side making the nth capture, if the exchange stopped there
+    int gains[32];
+    int numCaptures = 0;
+    gains[0] = exchangeScores[getCaptured(move)];
+    int pieceOnTarget = exchangeScores[getMoved(move)];
+    if (promoted != NULL_PIECE)
+    {
+        gains[0] += exchangeScores[promoted] - exchangeScores[getMoved(move)];
+        pieceOnTarget = exchangeScores[promoted];
+    }
+
+    U64 occupied = position.occupiedSquares ^ getBoard(from);
+    if (move & EN_PASSANT)
+    {
+        occupied ^= getBoard(position.isWhiteToMove ? south(to) : north(to));
+    }
+    U64 attackers = getAttackersTo(to, occupied);
+    bool isWhite = !position.isWhiteToMove;
+
+    while (true)
+    {
+        const U64 ourAttackers = attackers & (isWhite ? position.whitePieces : position.blackPieces);
+        if (!ourAttackers)
+        {
+            break;
+        }
+
+        // always recapture with the least valuable piece
+        Piece attacker = isWhite ? WHITE_PAWN : BLACK_PAWN;
+        while (!(ourAttackers & position.bitboards[attacker]))
+        {
+            attacker++;
+        }
+
+        // the king can only recapture if the other side has nothing left to take it with
+        if (attacker == (isWhite ? WHITE_KING : BLACK_KING) &&
+            (attackers & (isWhite ? position.blackPieces : position.whitePieces)))
+        {
+            break;
+        }
+
+        numCaptures++;
+        gains[numCaptures] = pieceOnTarget - gains[numCaptures - 1];
+        pieceOnTarget = exchangeScores[attacker];
+
+        occupied ^= getBoard(getSquare(ourAttackers & position.bitboards[attacker]));
+
+        // moving a piece off of a line can reveal a slider behind it
+        attackers |= getSlidingMoves<true>(to, occupied) & cardinalAttackers;
+        attackers |= getSlidingMoves<false>(to, occupied) & ordinalAttackers;
+        attackers &= occupied;
+        isWhite = !isWhite;
+    }
+
+    // each side can choose to stop capturing if continuing would lose material
+    while (numCaptures > 0)
+    {
+        gains[numCaptures - 1] = -std::max(-gains[numCaptures - 1], gains[numCaptures]);
+        numCaptures--;
+    }
+    return gains[0];
+}
+
 bool MoveGen::isInCheck(const int color)
 {
     return color == 1 ? isInCheck<true>() : isInCheck<false>();
-}
\ No newline at end of file
+}
+
+template void MoveGen::genLegalMoves<true, GEN_CAPTURES>();
+template void MoveGen::genLegalMoves<false, GEN_CAPTURES>();
+template void MoveGen::genLegalMoves<true, GEN_QUIETS>();
+template void MoveGen::genLegalMoves<false, GEN_QUIETS>();
+template void MoveGen::genLegalMoves<true, GEN_ALL>();
+template void MoveGen::genLegalMoves<false, GEN_ALL>();
+template bool MoveGen::isLegal<true>(const Move move);
+template bool MoveGen::isLegal<false>(const Move move);
+template bool MoveGen::isInCheck<true>();
+template bool MoveGen::isInCheck<false>();
@@ -8,6 +8,15 @@
 #include "Position.h"
 #include "Magics.h"
 #include "Moves.h"
+#include "Zobrist.h"
+
+// which moves to generate. captures also include promotions, so that the quiet moves are all non-tactical
+enum GenType
+{
+    GEN_CAPTURES,
+    GEN_QUIETS,
+    GEN_ALL
+};
 
 class MoveGen
 {
@@ -17,8 +26,26 @@ public:
     void genMoves();
     void genCaptures();
 
+    // every piece of either color attacking a square, if only the given squares were occupied
+    U64 getAttackersTo(const Square square, const U64 occupied);
+
+    // the material we expect to win or lose after both sides recapture on the target square
+    int getExchangeScore(const Move move);
+
     bool isInCheck(const int color);
 
+    // generate only the captures, only the quiet moves, or every legal move for one side
+    template<bool isWhite, GenType type>
+    void genLegalMoves();
+
+    // check if a move from somewhere else, like the transposition table, can be played here.
+    // this overwrites the move list
+    template<bool isWhite>
+    bool isLegal(const Move move);
+
+    template<bool isWhite>
+    bool isInCheck();
+
     int numMoves;
     Move moveList[256];
 
@@ -26,14 +53,17 @@ private:
     Position& position;
     const Magics& magics;
 
-    template<bool isWhite, bool quiets>
-    void genLegalMoves();
+    template<bool isWhite>
+    void updateLegality();
 
     U64 resolverSquares;
     U64 safeSquares;
     U64 cardinalPins;
     U64 ordinalPins;
 
+    // the position the squares and pins above were calculated for
+    Hash legalityHash;
+
     template<bool isWhite, bool isCardinal>
     void updatePins();
 
@@ -52,30 +82,33 @@ private:
     template<bool isWhite>
     void genPromotions(const Square from, const Square to, const Piece captured);
 
-    template<bool isWhite, bool quiets>
+    template<bool isWhite, GenType type>
+    U64 getTargets();
+
+    template<bool isWhite, GenType type>
     void genPawnMoves();
 
     template<bool isCardinal>
     U64 getSlidingMoves(Square from);
 
-    template<bool isWhite, bool quiets>
+    template<bool isCardinal>
+    U64 getSlidingMoves(Square from, U64 occupied);
+
+    template<bool isWhite, GenType type>
     void genKnightMoves();
 
-    template<bool isWhite, bool quiets>
+    template<bool isWhite, GenType type>
     void genBishopMoves();
 
-    template<bool isWhite, bool quiets>
+    template<bool isWhite, GenType type>
     void genRookMoves();
 
-    template<bool isWhite, bool quiets>
+    template<bool isWhite, GenType type>
     void genQueenMoves();
 
-    template<bool isWhite, bool quiets>
+    template<bool isWhite, GenType type>
     void genKingMoves();
 
-    template<bool isWhite>
-    bool isInCheck();
-
 
     void initKnightMoves();
     void initKingMoves();
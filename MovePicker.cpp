@@ -0,0 +1,248 @@
+#include <cstdlib>
+#include <cstring>
+#include "MovePicker.h"
+
+template<bool isWhite>
+MovePicker<isWhite>::MovePicker(
+    MoveGen& moveGen,
+    const Score (&captureScores)[13][13],
+    const CaptureHistory& captureHistory,
+    const ButterflyHistory& history,
+    const PieceToHistory* const (&continuations)[2],
+    const Move principalMove,
+    const Move killer1,
+    const Move killer2,
+    const Move counterMove)
+: moveGen(moveGen), captureScores(captureScores), captureHistory(captureHistory), history(&history)
+{
+    stage = PRINCIPAL_STAGE;
+    isQuiescent = false;
+    this->continuations[0] = continuations[0];
+    this->continuations[1] = continuations[1];
+    this->principalMove = principalMove;
+    killers[0] = killer1;
+    killers[1] = killer2;
+    this->counterMove = counterMove;
+    numMoves = 0;
+    moveIndex = 0;
+    numBadCaptures = 0;
+}
+
+template<bool isWhite>
+MovePicker<isWhite>::MovePicker(
+    MoveGen& moveGen,
+    const Score (&captureScores)[13][13],
+    const CaptureHistory& captureHistory,
+    const Move principalMove)
+: moveGen(moveGen), captureScores(captureScores), captureHistory(captureHistory), history(nullptr)
+{
+    stage = PRINCIPAL_STAGE;
+    isQuiescent = true;
+    continuations[0] = nullptr;
+    continuations[1] = nullptr;
+
+    // the best move stored for this position might be quiet
+    const bool isTactical = getCaptured(principalMove) != NULL_PIECE || getPromoted(principalMove) != NULL_PIECE;
+    this->principalMove = isTactical ? principalMove : NULL_MOVE;
+    killers[0] = NULL_MOVE;
+    killers[1] = NULL_MOVE;
+    counterMove = NULL_MOVE;
+    numMoves = 0;
+    moveIndex = 0;
+    numBadCaptures = 0;
+}
+
+template<bool isWhite>
+void MovePicker<isWhite>::scoreCaptures()
+{
+    for (int i = 0; i < numMoves; i++)
+    {
+        const Move move = moves[i];
+        scores[i] = captureScores[getMoved(move)][getCaptured(move)];
+
+        // a promotion is worth about as much as capturing the piece we promote to
+        if (getPromoted(move) != NULL_PIECE)
+        {
+            scores[i] += captureScores[NULL_PIECE][getPromoted(move)];
+        }
+
+        // the capture history can only break ties and swap captures of almost the same value
+        scores[i] *= 1024;
+        scores[i] += captureHistory[getMoved(move)][getTo(move)][getCaptured(move)] / 16;
+    }
+}
+
+template<bool isWhite>
+void MovePicker<isWhite>::scoreQuiets()
+{
+    for (int i = moveIndex; i < numMoves; i++)
+    {
+        const Move move = moves[i];
+        scores[i] = (*history)[getFrom(move)][getTo(move)];
+        scores[i] += (*continuations[0])[getMoved(move)][getTo(move)];
+        scores[i] += (*continuations[1])[getMoved(move)][getTo(move)];
+    }
+
+    // we will probably play most of the quiet moves, so sort them all at once
+    for (int i = moveIndex + 1; i < numMoves; i++)
+    {
+        const Move move = moves[i];
+        const int score = scores[i];
+        int j = i - 1;
+        while (j >= moveIndex && scores[j] < score)
+        {
+            moves[j + 1] = moves[j];
+            scores[j + 1] = scores[j];
+            j--;
+        }
+        moves[j + 1] = move;
+        scores[j + 1] = score;
+    }
+}
+
+template<bool isWhite>
+Move MovePicker<isWhite>::pickBestCapture()
+{
+    // an early capture usually causes a cutoff, so only find the best remaining one
+    int bestIndex = moveIndex;
+    for (int i = moveIndex + 1; i < numMoves; i++)
+    {
+        if (scores[i] > scores[bestIndex])
+        {
+            bestIndex = i;
+        }
+    }
+    const Move bestMove = moves[bestIndex];
+    moves[bestIndex] = moves[moveIndex];
+    scores[bestIndex] = scores[moveIndex];
+    moveIndex++;
+    return bestMove;
+}
+
+template<bool isWhite>
+bool MovePicker<isWhite>::isAlreadyPicked(const Move move) const
+{
+    return move == principalMove || move == killers[0] || move == killers[1] || move == counterMove;
+}
+
+template<bool isWhite>
+bool MovePicker<isWhite>::isQuietCandidate(const Move move) const
+{
+    // captures and promotions were already picked, and moves from other positions might not be legal here
+    return move != principalMove &&
+        getCaptured(move) == NULL_PIECE &&
+        getPromoted(move) == NULL_PIECE &&
+        moveGen.isLegal<isWhite>(move);
+}
+
+template<bool isWhite>
+Move MovePicker<isWhite>::nextMove()
+{
+    switch (stage)
+    {
+        case PRINCIPAL_STAGE:
+            stage = GEN_CAPTURES_STAGE;
+            if (principalMove != NULL_MOVE && moveGen.isLegal<isWhite>(principalMove))
+            {
+                return principalMove;
+            }
+            principalMove = NULL_MOVE;
+            [[fallthrough]];
+
+        case GEN_CAPTURES_STAGE:
+            moveGen.genLegalMoves<isWhite, GEN_CAPTURES>();
+            numMoves = moveGen.numMoves;
+            std::memcpy(moves, moveGen.moveList, numMoves * sizeof(Move));
+            moveIndex = 0;
+            scoreCaptures();
+            stage = CAPTURES_STAGE;
+            [[fallthrough]];
+
+        case CAPTURES_STAGE:
+            while (moveIndex < numMoves)
+            {
+                const Move move = pickBestCapture();
+                if (move == principalMove)
+                {
+                    continue;
+                }
+                // save captures that lose material for later, or skip them entirely in the quiescence search.
+                // taking a piece worth at least as much as the attacker can't lose material, so don't bother checking
+                if (std::abs(MATERIAL_SCORES[getCaptured(move)]) < std::abs(MATERIAL_SCORES[getMoved(move)]) &&
+                    moveGen.getExchangeScore(move) < 0)
+                {
+                    moves[numBadCaptures++] = move;
+                    continue;
+                }
+                return move;
+            }
+            if (isQuiescent)
+            {
+                stage = DONE_STAGE;
+                return NULL_MOVE;
+            }
+            stage = FIRST_KILLER_STAGE;
+            [[fallthrough]];
+
+        case FIRST_KILLER_STAGE:
+            stage = SECOND_KILLER_STAGE;
+            if (isQuietCandidate(killers[0]))
+            {
+                return killers[0];
+            }
+            [[fallthrough]];
+
+        case SECOND_KILLER_STAGE:
+            stage = COUNTER_MOVE_STAGE;
+            if (killers[1] != killers[0] && isQuietCandidate(killers[1]))
+            {
+                return killers[1];
+            }
+            [[fallthrough]];
+
+        case COUNTER_MOVE_STAGE:
+            stage = GEN_QUIETS_STAGE;
+            if (counterMove != killers[0] && counterMove != killers[1] && isQuietCandidate(counterMove))
+            {
+                return counterMove;
+            }
+            [[fallthrough]];
+
+        case GEN_QUIETS_STAGE:
+            moveGen.genLegalMoves<isWhite, GEN_QUIETS>();
+            numMoves = numBadCaptures + moveGen.numMoves;
+            std::memcpy(moves + numBadCaptures, moveGen.moveList, moveGen.numMoves * sizeof(Move));
+            moveIndex = numBadCaptures;
+            scoreQuiets();
+            stage = QUIETS_STAGE;
+            [[fallthrough]];
+
+        case QUIETS_STAGE:
+            while (moveIndex < numMoves)
+            {
+                const Move move = moves[moveIndex++];
+                if (!isAlreadyPicked(move))
+                {
+                    return move;
+                }
+            }
+            stage = BAD_CAPTURES_STAGE;
+            moveIndex = 0;
+            [[fallthrough]];
+
+        case BAD_CAPTURES_STAGE:
+            if (moveIndex < numBadCaptures)
+            {
+                return moves[moveIndex++];
+            }
+            stage = DONE_STAGE;
+            [[fallthrough]];
+
+        case DONE_STAGE:
+            return NULL_MOVE;
+    }
+    return NULL_MOVE;
+}
+
+template class MovePicker<true>;
+template class MovePicker<false>;
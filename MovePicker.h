@@ -0,0 +1,97 @@
+#ifndef KARL_MOVEPICKER_H
+#define KARL_MOVEPICKER_H
+
+#include "Eval.h"
+#include "MoveGen.h"
+
+// how well quiet moves have done, indexed by the squares they move from and to
+typedef int ButterflyHistory[64][64];
+
+// how well quiet moves have done right after some other move, indexed by the piece moving and the square it moves to
+typedef int PieceToHistory[13][64];
+
+// how well captures have done, indexed by the piece moving, the square it moves to and the piece captured
+typedef int CaptureHistory[13][64][13];
+
+/*
+ * Hands out the moves of a position one at a time, best first, and only generates them when they are needed:
+ *
+ * 1. the move from the transposition table, checked for legality without generating anything
+ * 2. captures and promotions that don't lose material, best victim and cheapest attacker first
+ * 3. killer moves, then the move that last refuted the opponent's move
+ * 4. every other quiet move, sorted by history and by how they did after the last two moves
+ * 5. captures that lose material
+ *
+ * if an earlier move causes a beta cutoff, the quiet moves are never generated.
+ * the quiescence search only gets the captures that don't lose material.
+ * isWhite is the side to move, so the move generator doesn't have to check it
+ */
+template<bool isWhite>
+class MovePicker
+{
+public:
+    // for the normal search
+    MovePicker(
+        MoveGen& moveGen,
+        const Score (&captureScores)[13][13],
+        const CaptureHistory& captureHistory,
+        const ButterflyHistory& history,
+        const PieceToHistory* const (&continuations)[2],
+        const Move principalMove,
+        const Move killer1,
+        const Move killer2,
+        const Move counterMove);
+
+    // for the quiescence search, which only looks at captures and promotions
+    MovePicker(
+        MoveGen& moveGen,
+        const Score (&captureScores)[13][13],
+        const CaptureHistory& captureHistory,
+        const Move principalMove);
+
+    Move nextMove();
+
+private:
+    enum Stage
+    {
+        PRINCIPAL_STAGE,
+        GEN_CAPTURES_STAGE,
+        CAPTURES_STAGE,
+        FIRST_KILLER_STAGE,
+        SECOND_KILLER_STAGE,
+        COUNTER_MOVE_STAGE,
+        GEN_QUIETS_STAGE,
+        QUIETS_STAGE,
+        BAD_CAPTURES_STAGE,
+        DONE_STAGE
+    };
+
+    MoveGen& moveGen;
+    const Score (&captureScores)[13][13];
+    const CaptureHistory& captureHistory;
+    const ButterflyHistory* history;
+    const PieceToHistory* continuations[2];
+
+    Stage stage;
+    bool isQuiescent;
+
+    Move principalMove;
+    Move killers[2];
+    Move counterMove;
+
+    // losing captures are moved to the front of the list as they are found, and the quiet moves go after them
+    Move moves[256];
+    int scores[256];
+    int numMoves;
+    int moveIndex;
+    int numBadCaptures;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    Move pickBestCapture();
+    bool isAlreadyPicked(const Move move) const;
+    bool isQuietCandidate(const Move move) const;
+};
+
+
+#endif //KARL_MOVEPICKER_H
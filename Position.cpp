@@ -27,6 +27,30 @@ Position::Position(const Zobrist& zobrist)
     irreversibles = {};
 }
 
+Position& Position::operator=(const Position& other)
+{
+    // every position shares the same zobrist keys, so copy everything else
+    hash = other.hash;
+    std::memcpy(history, other.history, sizeof(history));
+    std::memcpy(bitboards, other.bitboards, sizeof(bitboards));
+    std::memcpy(pieces, other.pieces, sizeof(pieces));
+
+    emptySquares = other.emptySquares;
+    occupiedSquares = other.occupiedSquares;
+    whitePieces = other.whitePieces;
+    blackPieces = other.blackPieces;
+    whiteOrEmpty = other.whiteOrEmpty;
+    blackOrEmpty = other.blackOrEmpty;
+
+    placementScore = other.placementScore;
+    materialScore = other.materialScore;
+
+    totalPlies = other.totalPlies;
+    isWhiteToMove = other.isWhiteToMove;
+    irreversibles = other.irreversibles;
+    return *this;
+}
+
 bool Position::loadFen(const std::string& fen)
 {
     clear();
@@ -199,11 +223,12 @@ void Position::unMakeMove(const Move move, const Irreversibles& state)
 
 bool Position::isZugzwang()
 {
-    U64 heavies = bitboards[isWhiteToMove ? WHITE_QUEEN : BLACK_QUEEN];
-    heavies |= bitboards[isWhiteToMove ? WHITE_BISHOP : BLACK_BISHOP];
-    heavies |= bitboards[isWhiteToMove ? WHITE_ROOK : BLACK_ROOK];
-    return !static_cast<bool>(heavies);
-
+    // with only a king and pawns left, passing is often better than any real move
+    U64 pieces = bitboards[isWhiteToMove ? WHITE_QUEEN : BLACK_QUEEN];
+    pieces |= bitboards[isWhiteToMove ? WHITE_BISHOP : BLACK_BISHOP];
+    pieces |= bitboards[isWhiteToMove ? WHITE_ROOK : BLACK_ROOK];
+    pieces |= bitboards[isWhiteToMove ? WHITE_KNIGHT : BLACK_KNIGHT];
+    return !static_cast<bool>(pieces);
 }
 
 void Position::makeNullMove()
@@ -521,4 +546,9 @@ void Position::updateBitboards()
     emptySquares = ~occupiedSquares;
     whiteOrEmpty = whitePieces | emptySquares;
     blackOrEmpty = blackPieces | emptySquares;
-}
\ No newline at end of file
+}
+
+template void Position::doMove<true>(const Move move);
+template void Position::doMove<false>(const Move move);
+template void Position::undoMove<true>(const Move move, const Irreversibles& state);
+template void Position::undoMove<false>(const Move move, const Irreversibles& state);
@@ -32,6 +32,8 @@ class Position
 {
 public:
     Position(const Zobrist& zobrist);
+    Position(const Position& other) = default;
+    Position& operator=(const Position& other);
     bool loadFen(const std::string& fen);
 
     struct Irreversibles
@@ -66,6 +68,13 @@ public:
     void makeMove(const Move move);
     void unMakeMove(const Move move, const Irreversibles& state);
 
+    // makeMove and unMakeMove with the side to move fixed at compile time, so the search never branches on it
+    template<bool isWhite>
+    void doMove(const Move move);
+
+    template<bool isWhite>
+    void undoMove(const Move move, const Irreversibles& state);
+
     bool isZugzwang();
     void makeNullMove();
     void unMakeNullMove(const int enPassantBefore);
@@ -74,12 +83,6 @@ public:
 private:
     const Zobrist& zobrist;
 
-    template<bool isWhite>
-    void doMove(const Move move);
-
-    template<bool isWhite>
-    void undoMove(const Move move, const Irreversibles& state);
-
     void clear();
 
 };
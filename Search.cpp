@@ -4,46 +4,179 @@
 
 #include "Search.h"
 #include "Notation.h"
+#include "MovePicker.h"
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
 
-struct Node
-{
-    Move bestMove;
-    Hash hash;
-};
-
-inline constexpr int TRANSPOSITION_TABLE_SIZE = 1048583;
-Node transpositionTable[TRANSPOSITION_TABLE_SIZE];
-
-Search::Search(Position& position, MoveGen& moveGen, Evaluator& evaluator)
-: position(position), moveGen(moveGen), evaluator(evaluator)
+Search::Search(
+    Position& position,
+    MoveGen& moveGen,
+    Evaluator& evaluator,
+    TranspositionTable& transpositions,
+    std::atomic<bool>& isStopped)
+: position(position),
+  moveGen(moveGen),
+  evaluator(evaluator),
+  transpositions(transpositions),
+  isStopped(isStopped)
 {
     branchNodes = 0;
     leafNodes = 0;
     quietNodes = 0;
+    totalNodes = 0;
+    reverseFutilityPrunes = 0;
+    futilityPrunes = 0;
+    razoringPrunes = 0;
+    lateMovePrunes = 0;
+    historyPrunes = 0;
+    nullMoveAttempts = 0;
+    nullMoveCutoffs = 0;
+    nullMoveVerifications = 0;
+    iirReductions = 0;
+    checkExtensions = 0;
+    recaptureExtensions = 0;
+    pawnExtensions = 0;
+    selDepth = 0;
 
-    endTime = 0;
+    rootDepth = 0;
     isOutOfTime = false;
+    isHelper = false;
+    rootHash = 0;
+    iirDepth = DEFAULT_IIR_DEPTH;
+    multiPv = 1;
+    pvIndex = 0;
+    depthLimit = 0;
+    nodeLimit = 0;
+    followedPv = nullptr;
+    helperNodes = nullptr;
+    publishedNodes = 0;
+    ponderMove = NULL_MOVE;
 
-    initKillerMoves();
+    continuationHistory = std::make_unique<PieceToHistory[]>(13 * 64);
+    initSearchStack();
     initCaptureScores();
-    initTranspositions();
+    initReductions();
     initHistory();
 }
 
-void Search::initKillerMoves()
+void Search::initSearchStack()
 {
-    std::memset(killerMoves, 0, sizeof(killerMoves));
+    for (SearchStack& entry : searchStack)
+    {
+        entry.ply = 0;
+        entry.extensions = 0;
+        entry.staticEval = NO_EVAL;
+        entry.currentMove = NULL_MOVE;
+        entry.continuationHistory = &continuationHistory[0];
+        entry.killerMoves[0] = NULL_MOVE;
+        entry.killerMoves[1] = NULL_MOVE;
+        entry.isImproving = false;
+        entry.pvLength = 0;
+        entry.isFollowingPv = false;
+    }
 }
 
 void Search::initHistory()
 {
     std::memset(history, 0, sizeof(history));
+    std::memset(captureHistory, 0, sizeof(captureHistory));
+    std::memset(counterMoves, 0, sizeof(counterMoves));
+    std::memset(continuationHistory.get(), 0, 13 * 64 * sizeof(PieceToHistory));
+}
+
+void Search::updateHistory(int& score, const int bonus)
+{
+    // pull big scores back towards zero, so they stay in range and old results fade away
+    score += bonus - score * std::abs(bonus) / MAX_HISTORY;
+}
+
+int Search::getQuietHistory(const SearchStack* stack, const Move move, const bool isWhite)
+{
+    return history[isWhite][getFrom(move)][getTo(move)]
+        + (*(stack - 1)->continuationHistory)[getMoved(move)][getTo(move)]
+        + (*(stack - 2)->continuationHistory)[getMoved(move)][getTo(move)];
+}
+
+void Search::updateQuietHistory(const SearchStack* stack, const Move move, const bool isWhite, const int bonus)
+{
+    updateHistory(history[isWhite][getFrom(move)][getTo(move)], bonus);
+
+    // a null move or the start of the search has no continuation
+    for (int i = 1; i <= 2; i++)
+    {
+        if ((stack - i)->currentMove != NULL_MOVE)
+        {
+            updateHistory((*(stack - i)->continuationHistory)[getMoved(move)][getTo(move)], bonus);
+        }
+    }
+}
+
+void Search::prefetch()
+{
+    // the child node probes the transposition table and evaluates right away,
+    // so start loading both while we finish up here
+    transpositions.prefetch(position.hash);
+    evaluator.prefetch();
+}
+
+void Search::setCurrentMove(SearchStack* stack, const Move move)
+{
+    stack->currentMove = move;
+    stack->continuationHistory = &continuationHistory[move == NULL_MOVE ? 0 : getMoved(move) * 64 + getTo(move)];
 }
 
-void Search::initTranspositions()
+void Search::updatePrincipalVariation(SearchStack* stack, const Move move)
 {
-    std::memset(transpositionTable, 0, sizeof(transpositionTable));
+    // our line is the move that raised alpha, followed by the line our child found after it
+    const SearchStack* child = stack + 1;
+    stack->pv[0] = move;
+    std::memcpy(stack->pv + 1, child->pv, child->pvLength * sizeof(Move));
+    stack->pvLength = child->pvLength + 1;
+}
+
+Score Search::scoreToTransposition(const Score score, const int ply)
+{
+    // mate scores are stored as the distance to mate from this node, not from the root
+    if (score >= MIN_MATE_SCORE)
+    {
+        return score + ply;
+    }
+    if (score <= -MIN_MATE_SCORE)
+    {
+        return score - ply;
+    }
+    return score;
+}
+
+Score Search::scoreFromTransposition(const Score score, const int ply)
+{
+    if (score >= MIN_MATE_SCORE)
+    {
+        return score - ply;
+    }
+    if (score <= -MIN_MATE_SCORE)
+    {
+        return score + ply;
+    }
+    return score;
+}
+
+void Search::initReductions()
+{
+    for (int depth = 0; depth < MAX_DEPTH; depth++)
+    {
+        for (int moveNum = 0; moveNum < 256; moveNum++)
+        {
+            if (depth == 0 || moveNum == 0)
+            {
+                reductions[depth][moveNum] = 0;
+                continue;
+            }
+            // the deeper we are and the later the move, the less likely it is to be best
+            reductions[depth][moveNum] = static_cast<int>(0.75 + std::log(depth) * std::log(moveNum) / 2.25);
+        }
+    }
 }
 
 void Search::initCaptureScores()
@@ -64,60 +197,86 @@ void Search::initCaptureScores()
     }
 }
 
-template<bool isQuiescent>
-void Search::orderMove(
-    Move moves[256],
-    const int numMoves,
+template<bool isWhite>
+int Search::getReduction(
+    const SearchStack* stack,
+    const Move move,
     const int moveNum,
     const int depth,
-    const int color,
-    const Move principalMove)
+    const bool isInCheck,
+    const bool isPrincipalNode)
 {
-    Score bestScore = MIN_SCORE;
-    int bestMoveIndex = -1;
-    for (int i = moveNum; i < numMoves; i++)
+    // never reduce the first few moves, tactical moves, or check evasions
+    if (depth < 3 ||
+        moveNum < (isPrincipalNode ? 3 : 2) ||
+        isInCheck ||
+        getCaptured(move) != NULL_PIECE ||
+        getPromoted(move) != NULL_PIECE)
     {
-        Score score = 0;
-        const Move move = moves[i];
+        return 0;
+    }
 
-        if constexpr (isQuiescent)
-        {
-            score = captureScores[getMoved(move)][getCaptured(move)];
-        }
-        // during the normal search
-        else
-        {
-            if (move == principalMove)
-            {
-                // principal variation moves are best
-                score = INT_MAX;
-            }
-            else if (getCaptured(move) != NULL_PIECE)
-            {
-                // order moves based on capture value and piece value
-                score = INT_MAX - 100 + captureScores[getMoved(move)][getCaptured(move)];
-            }
-            else if (move == killerMoves[depth][0] || move == killerMoves[depth][1])
-            {
-                // put killer moves after captures
-                score = INT_MAX - 200;
-            }
-            else
-            {
-                // order other quiet moves by history
-                score = history[color == -1 ? 0 : 1][getFrom(move)][getTo(move)];
-            }
-        }
-        if (score > bestScore)
-        {
-            bestScore = score;
-            bestMoveIndex = i;
-        }
+    int reduction = reductions[std::min(depth, MAX_DEPTH - 1)][std::min(moveNum, 255)];
+    if (isPrincipalNode)
+    {
+        reduction--;
+    }
+    if (move == stack->killerMoves[0] || move == stack->killerMoves[1])
+    {
+        reduction--;
     }
+    // moves that have been good elsewhere in the tree are reduced less
+    reduction -= std::clamp(getQuietHistory(stack, move, isWhite) / 8192, -1, 2);
 
-    Move bestMove = moves[bestMoveIndex];
-    moves[bestMoveIndex] = moves[moveNum];
-    moves[moveNum] = bestMove;
+    // don't reduce moves that give check. the move has already been made, so the opponent is in check
+    if (reduction > 0 && moveGen.isInCheck<!isWhite>())
+    {
+        return 0;
+    }
+    return std::clamp(reduction, 0, depth - 2);
+}
+
+template<bool isWhite>
+int Search::getExtension(
+    const SearchStack* stack,
+    const Move move,
+    const bool isPrincipalNode)
+{
+    // every extension on this path comes out of the same budget
+    if (stack->extensions >= rootDepth / EXTENSION_BUDGET_DIVISOR)
+    {
+        return 0;
+    }
+
+    // the move has already been made, so the opponent is in check.
+    // searching the evasions to the full depth keeps a checking sequence from being cut off at the horizon
+    if (moveGen.isInCheck<!isWhite>())
+    {
+        checkExtensions++;
+        return 1;
+    }
+
+    // taking back a piece is almost forced, so don't let the exchange use up the depth
+    const Move previousMove = (stack - 1)->currentMove;
+    if (isPrincipalNode &&
+        previousMove != NULL_MOVE &&
+        getCaptured(move) != NULL_PIECE &&
+        getCaptured(previousMove) != NULL_PIECE &&
+        getTo(move) == getTo(previousMove))
+    {
+        recaptureExtensions++;
+        return 1;
+    }
+
+    // a pawn about to promote needs a closer look
+    const int rank = getRank(getTo(move));
+    if ((getMoved(move) == WHITE_PAWN && rank == SEVENTH_RANK) ||
+        (getMoved(move) == BLACK_PAWN && rank == SECOND_RANK))
+    {
+        pawnExtensions++;
+        return 1;
+    }
+    return 0;
 }
 
 bool Search::isRepetition()
@@ -134,51 +293,181 @@ bool Search::isRepetition()
     return repetitions >= 3;
 }
 
-Score Search::quiescence(Score alpha, const Score beta, const int color)
+void Search::publishNodes()
+{
+    if (isHelper && helperNodes)
+    {
+        const U64 nodes = totalNodes + branchNodes + quietNodes;
+        helperNodes->fetch_add(nodes - publishedNodes, std::memory_order_relaxed);
+        publishedNodes = nodes;
+    }
+}
+
+bool Search::shouldStop()
+{
+    // helpers share their node count every few thousand nodes, so the main thread can report it while we search
+    if ((branchNodes & 4095) == 0)
+    {
+        publishNodes();
+    }
+    // the first iteration is always allowed to finish, so we have a move to fall back on
+    if (rootDepth > 1 && isStopped.load(std::memory_order_relaxed))
+    {
+        isOutOfTime = true;
+    }
+    if (nodeLimit && rootDepth > 1 && totalNodes + branchNodes + quietNodes >= nodeLimit)
+    {
+        isOutOfTime = true;
+    }
+    return isOutOfTime;
+}
+
+template<bool isWhite>
+Score Search::quiescence(SearchStack* stack, Score alpha, const Score beta)
 {
+    constexpr int color = isWhite ? 1 : -1;
+    if (shouldStop())
+    {
+        return alpha;
+    }
     quietNodes++;
-    Score score = evaluator.evaluate() * color;
-    if (score >= beta)
+
+    // a long series of checks and evasions could go on forever, so stop somewhere
+    const int ply = stack->ply;
+    selDepth = std::max(selDepth, ply);
+    if (ply >= MAX_DEPTH)
     {
-        return beta;
+        return evaluator.evaluate() * color;
     }
-    if (score > alpha)
+    const Score alphaBefore = alpha;
+
+    // any result stored for this position is at least as deep as the quiescence search
+    Move principalMove = NULL_MOVE;
+    Score staticEval = 0;
+    TranspositionEntry entry;
+    if (transpositions.probe(position.hash, entry))
     {
-        alpha = score;
+        const Score score = scoreFromTransposition(entry.score, ply);
+        const Bound bound = entry.getBound();
+        if (bound == EXACT_BOUND ||
+            (bound == LOWER_BOUND && score >= beta) ||
+            (bound == UPPER_BOUND && score <= alpha))
+        {
+            return std::max(alpha, std::min(beta, score));
+        }
+        principalMove = entry.bestMove;
+        staticEval = entry.staticEval;
+    }
+    else
+    {
+        staticEval = evaluator.evaluate() * color;
     }
 
-    moveGen.genCaptures();
-    Move captures[256];
-    std::memcpy(captures, moveGen.moveList, sizeof moveGen.moveList);
-    const int numCaptures = moveGen.numMoves;
+    // when in check we can't stand pat, because the position might be lost. search every evasion instead
+    const bool isInCheck = moveGen.isInCheck<isWhite>();
+    if (!isInCheck)
+    {
+        if (staticEval >= beta)
+        {
+            transpositions.store(position.hash, NULL_MOVE, scoreToTransposition(beta, ply), staticEval, 0, LOWER_BOUND);
+            return beta;
+        }
+        if (staticEval > alpha)
+        {
+            alpha = staticEval;
+        }
+    }
+
+    const PieceToHistory* const continuations[2] = {
+        (stack - 1)->continuationHistory,
+        (stack - 2)->continuationHistory
+    };
+    MovePicker<isWhite> picker = isInCheck
+        ? MovePicker<isWhite>(
+            moveGen,
+            captureScores,
+            captureHistory,
+            history[isWhite],
+            continuations,
+            principalMove,
+            NULL_MOVE,
+            NULL_MOVE,
+            NULL_MOVE)
+        : MovePicker<isWhite>(moveGen, captureScores, captureHistory, principalMove);
     const Position::Irreversibles state = position.irreversibles;
-    for (int captureNum = 0; captureNum < numCaptures; captureNum++)
+
+    Move bestMove = NULL_MOVE;
+    int moveNum = 0;
+    for (Move move = picker.nextMove(); move != NULL_MOVE; move = picker.nextMove(), moveNum++)
     {
-        orderMove<true>(captures, numCaptures, captureNum, -1, color, NULL_MOVE);
-        const Move move = captures[captureNum];
-        position.makeMove(move);
-        score = -quiescence(-beta, -alpha, -color);
-        position.unMakeMove(move, state);
+        // delta pruning. skip captures that can't raise alpha even if they win material for free
+        if (!isInCheck)
+        {
+            Score gain = std::abs(MATERIAL_SCORES[getCaptured(move)]);
+            if (getPromoted(move) != NULL_PIECE)
+            {
+                gain += std::abs(MATERIAL_SCORES[getPromoted(move)]) - MATERIAL_SCORES[WHITE_PAWN];
+            }
+            if (staticEval + gain + DELTA_MARGIN <= alpha)
+            {
+                continue;
+            }
+        }
+
+        setCurrentMove(stack, move);
+        (stack + 1)->ply = ply + 1;
+        position.doMove<isWhite>(move);
+        prefetch();
+        const Score score = -quiescence<!isWhite>(stack + 1, -beta, -alpha);
+        position.undoMove<isWhite>(move, state);
+        if (isOutOfTime)
+        {
+            return alpha;
+        }
         if (score >= beta)
         {
+            transpositions.store(position.hash, move, scoreToTransposition(beta, ply), staticEval, 0, LOWER_BOUND);
             return beta;
         }
         if (score > alpha)
         {
             alpha = score;
+            bestMove = move;
         }
     }
+
+    if (isInCheck && moveNum == 0)
+    {
+        // checkmate
+        return MIN_SCORE + ply;
+    }
+
+    transpositions.store(
+        position.hash,
+        bestMove,
+        scoreToTransposition(alpha, ply),
+        staticEval,
+        0,
+        alpha > alphaBefore ? EXACT_BOUND : UPPER_BOUND);
     return alpha;
 }
 
+template<bool isWhite, NodeType nodeType>
 Score Search::negamax(
-    const int color,
-    const int depth,
+    SearchStack* stack,
+    int depth,
     const bool isNull,
     Score alpha,
     Score beta)
 {
-    if (isOutOfTime)
+    constexpr int color = isWhite ? 1 : -1;
+    constexpr bool isPrincipalNode = nodeType == PRINCIPAL_NODE;
+    if constexpr (isPrincipalNode)
+    {
+        // whatever we return early, our parent must not copy a line left over from another node
+        stack->pvLength = 0;
+    }
+    if (shouldStop())
     {
         return TIMEOUT;
     }
@@ -190,226 +479,747 @@ Score Search::negamax(
 
     if (depth <= 0)
     {
-        // check if we ran out of time every few thousand leaf nodes
-        if ((++leafNodes & 8191) == 0 && getEpochMillis() > endTime)
+        leafNodes++;
+        return quiescence<isWhite>(stack, alpha, beta);
+    }
+
+    const int ply = stack->ply;
+    selDepth = std::max(selDepth, ply);
+    if (ply >= MAX_DEPTH)
+    {
+        return evaluator.evaluate() * color;
+    }
+
+    // our children start with fresh killer moves, and share them with each other
+    (stack + 1)->ply = ply + 1;
+    (stack + 1)->extensions = stack->extensions;
+    (stack + 2)->killerMoves[0] = NULL_MOVE;
+    (stack + 2)->killerMoves[1] = NULL_MOVE;
+
+    // look this position up before doing any real work
+    Move principalMove = NULL_MOVE;
+    Score staticEval = 0;
+    TranspositionEntry entry;
+    const bool isTransposition = transpositions.probe(position.hash, entry);
+    if (isTransposition)
+    {
+        principalMove = entry.bestMove;
+        staticEval = entry.staticEval;
+
+        // a deep enough result from an earlier search can be used without searching again
+        if (!isPrincipalNode && entry.depth >= depth)
         {
-            isOutOfTime = true;
-            return TIMEOUT;
+            const Score score = scoreFromTransposition(entry.score, ply);
+            const Bound bound = entry.getBound();
+            if (bound == EXACT_BOUND ||
+                (bound == LOWER_BOUND && score >= beta) ||
+                (bound == UPPER_BOUND && score <= alpha))
+            {
+                return std::max(alpha, std::min(beta, score));
+            }
         }
+    }
+    else
+    {
+        staticEval = evaluator.evaluate() * color;
+    }
 
-        return quiescence(alpha, beta, color);
+    if constexpr (isPrincipalNode)
+    {
+        // the table can lose entries of the last principal variation, so fall back on the line we saved for it
+        const SearchStack* parent = stack - 1;
+        stack->isFollowingPv = parent->isFollowingPv &&
+            ply < static_cast<int>(followedPv->size()) &&
+            parent->currentMove == (*followedPv)[ply - 1];
+        if (stack->isFollowingPv && principalMove == NULL_MOVE)
+        {
+            principalMove = (*followedPv)[ply];
+        }
     }
 
-    const bool isInCheck = moveGen.isInCheck(color);
-    if (!isNull && !isInCheck && depth >= 4 && !position.isZugzwang())
+    const bool isInCheck = moveGen.isInCheck<isWhite>();
+
+    // if our position got better since our last move, moves here are more likely to fail high
+    stack->staticEval = isInCheck ? NO_EVAL : staticEval;
+    const Score lastStaticEval = (stack - 2)->staticEval;
+    stack->isImproving = !isInCheck && (lastStaticEval == NO_EVAL || staticEval > lastStaticEval);
+    const bool isImproving = stack->isImproving;
+
+    if (!isPrincipalNode && !isInCheck && std::abs(beta) < MIN_MATE_SCORE)
     {
-        const int enPassantBefore = position.irreversibles.enPassantFile;
-        position.makeNullMove();
-        int score = -negamax(-color, depth - 4, true, -beta, -beta + 1);
-        position.unMakeNullMove(enPassantBefore);
-        if (score >= beta)
+        // reverse futility pruning. if we are far enough above beta, assume one of our moves will keep us there
+        if (depth <= REVERSE_FUTILITY_DEPTH &&
+            staticEval - REVERSE_FUTILITY_MARGIN * (depth - isImproving) >= beta)
         {
+            reverseFutilityPrunes++;
             return beta;
         }
+
+        // razoring. if we are far below alpha this close to the horizon, only a capture could save us
+        if (depth <= RAZORING_DEPTH && staticEval + RAZORING_MARGIN * depth <= alpha)
+        {
+            const Score score = quiescence<isWhite>(stack, alpha, beta);
+            if (isOutOfTime)
+            {
+                return TIMEOUT;
+            }
+            if (score <= alpha)
+            {
+                razoringPrunes++;
+                return alpha;
+            }
+        }
     }
 
-    branchNodes++;
-    moveGen.genMoves();
-    const int numMoves = moveGen.numMoves;
-    if (numMoves == 0)
+    // futility pruning. near the horizon, quiet moves can't bring a position far below alpha back up
+    const bool isFutile = !isPrincipalNode &&
+        !isInCheck &&
+        depth <= FUTILITY_DEPTH &&
+        std::abs(alpha) < MIN_MATE_SCORE &&
+        staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+    // null move pruning. if we pass and the opponent still can't get below beta, this position is too good.
+    // only try it when we are already above beta, because otherwise passing almost never fails high
+    if (!isNull &&
+        !isInCheck &&
+        depth >= NULL_MOVE_DEPTH &&
+        staticEval >= beta &&
+        std::abs(beta) < MIN_MATE_SCORE &&
+        !position.isZugzwang())
     {
-        if (isInCheck)
+        // reduce more the deeper we are and the farther we are above beta
+        const int reduction = NULL_MOVE_REDUCTION + depth / 4 + std::min((staticEval - beta) / 200, 3);
+        const int nullDepth = std::max(depth - 1 - reduction, 0);
+
+        nullMoveAttempts++;
+        const int enPassantBefore = position.irreversibles.enPassantFile;
+        setCurrentMove(stack, NULL_MOVE);
+        position.makeNullMove();
+        prefetch();
+        Score score = -negamax<!isWhite, NON_PRINCIPAL_NODE>(stack + 1, nullDepth, true, -beta, -beta + 1);
+        position.unMakeNullMove(enPassantBefore);
+        if (isOutOfTime)
         {
-            // return a checkmate score, and lower the score the farther the checkmate is
-            return MIN_SCORE + MAX_DEPTH - depth;
+            return TIMEOUT;
         }
-        else
+
+        // deep in the tree a wrong cutoff from zugzwang costs a lot, so make sure with a real search.
+        // the verification search can't use a null move itself
+        if (score >= beta && depth >= NULL_MOVE_VERIFICATION_DEPTH)
         {
-            // this is a draw by stalemate, so return the contempt factor
-            return CONTEMPT;
+            nullMoveVerifications++;
+            score = negamax<isWhite, NON_PRINCIPAL_NODE>(stack, nullDepth, true, beta - 1, beta);
+            if (isOutOfTime)
+            {
+                return TIMEOUT;
+            }
+        }
+        if (score >= beta)
+        {
+            nullMoveCutoffs++;
+            transpositions.store(
+                position.hash,
+                NULL_MOVE,
+                scoreToTransposition(beta, ply),
+                staticEval,
+                depth,
+                LOWER_BOUND);
+            return beta;
         }
     }
 
-    Move principalMove = NULL_MOVE;
-    const Hash key = position.hash % TRANSPOSITION_TABLE_SIZE;
-    Node& node = transpositionTable[key];
-    if (node.hash == position.hash)
+    // internal iterative reduction. without a move from the transposition table our move ordering is poor,
+    // so a full depth search here would be expensive. search it shallower, and the next iteration will have a move
+    if (iirDepth > 0 && depth >= iirDepth && principalMove == NULL_MOVE)
     {
-        principalMove = node.bestMove;
+        iirReductions++;
+        depth--;
     }
 
-    Move moves[256];
-    std::memcpy(moves, moveGen.moveList, sizeof moveGen.moveList);
+    branchNodes++;
+    const Move previousMove = (stack - 1)->currentMove;
+    Move* counterMove = previousMove != NULL_MOVE ? &counterMoves[getMoved(previousMove)][getTo(previousMove)] : nullptr;
+    const PieceToHistory* const continuations[2] = {
+        (stack - 1)->continuationHistory,
+        (stack - 2)->continuationHistory
+    };
+    MovePicker<isWhite> picker(
+        moveGen,
+        captureScores,
+        captureHistory,
+        history[isWhite],
+        continuations,
+        principalMove,
+        stack->killerMoves[0],
+        stack->killerMoves[1],
+        counterMove ? *counterMove : NULL_MOVE);
     const Position::Irreversibles state = position.irreversibles;
 
+    Move quietsSearched[256];
+    int numQuietsSearched = 0;
+    Move capturesSearched[256];
+    int numCapturesSearched = 0;
+
     Move bestMove = NULL_MOVE;
-    for (int moveNum = 0; moveNum < numMoves; moveNum++)
+    int moveNum = 0;
+    for (Move move = picker.nextMove(); move != NULL_MOVE; move = picker.nextMove(), moveNum++)
     {
         Score score = 0;
-        orderMove<false>(moves, numMoves, moveNum, depth, color, principalMove);
-        const Move move = moves[moveNum];
+        const bool isQuiet = getCaptured(move) == NULL_PIECE && getPromoted(move) == NULL_PIECE;
+
+        // near the horizon, quiet moves this late in the ordering or with a bad history rarely change anything,
+        // so skip them without even making the move. the quiets are sorted by history, so late move pruning
+        // already drops the worst of them at its depths. history pruning reaches a little deeper than that
+        if (!isPrincipalNode && !isInCheck && isQuiet && moveNum > 0 && std::abs(alpha) < MIN_MATE_SCORE)
+        {
+            if (depth <= LATE_MOVE_PRUNING_DEPTH &&
+                moveNum >= (LATE_MOVE_PRUNING_BASE + depth * depth) / (isImproving ? 1 : 2))
+            {
+                lateMovePrunes++;
+                continue;
+            }
+            if (depth <= HISTORY_PRUNING_DEPTH &&
+                getQuietHistory(stack, move, isWhite) < -HISTORY_PRUNING_MARGIN * depth)
+            {
+                historyPrunes++;
+                continue;
+            }
+        }
 
-        position.makeMove(move);
+        setCurrentMove(stack, move);
+        position.doMove<isWhite>(move);
+        prefetch();
+        if constexpr (isPrincipalNode)
+        {
+            // a child searched with a null window leaves no line behind
+            (stack + 1)->pvLength = 0;
+        }
+        if (isFutile && moveNum > 0 && isQuiet && !moveGen.isInCheck<!isWhite>())
+        {
+            position.undoMove<isWhite>(move, state);
+            futilityPrunes++;
+            continue;
+        }
+
+        const int extension = getExtension<isWhite>(stack, move, isPrincipalNode);
+        const int newDepth = depth - 1 + extension;
+        (stack + 1)->extensions = stack->extensions + extension;
         if (move == principalMove)
         {
             // do a full width search for a node in the principal variation
-            score = -negamax(-color, depth - 1, false, -beta, -alpha);
+            score = -negamax<!isWhite, nodeType>(stack + 1, newDepth, false, -beta, -alpha);
         }
         else
         {
-            // do a null window search for non principal variation nodes
-            score = -negamax(-color, depth - 1, false, -alpha - 1, -alpha);
-            // if the null window search did not fail low or high
-            if (score > alpha && score < beta)
+            const int reduction = getReduction<isWhite>(stack, move, moveNum, depth, isInCheck, isPrincipalNode);
+            if (reduction > 0)
+            {
+                // search late quiet moves to a shallower depth, because they probably won't raise alpha
+                score = -negamax<!isWhite, NON_PRINCIPAL_NODE>(stack + 1, newDepth - reduction, false, -alpha - 1, -alpha);
+            }
+            // if the reduced search raised alpha, we can't trust it until we search to the full depth
+            if (reduction == 0 || score > alpha)
+            {
+                // do a null window search for non principal variation nodes
+                score = -negamax<!isWhite, NON_PRINCIPAL_NODE>(stack + 1, newDepth, false, -alpha - 1, -alpha);
+            }
+            // if the null window search did not fail low or high. only a principal node has room between them
+            if (isPrincipalNode && score > alpha && score < beta)
             {
                 // search it again with a full window
-                score = -negamax(-color, depth - 1, false, -beta, -alpha);
+                score = -negamax<!isWhite, PRINCIPAL_NODE>(stack + 1, newDepth, false, -beta, -alpha);
             }
         }
-        position.unMakeMove(move, state);
+        position.undoMove<isWhite>(move, state);
+
+        if (isOutOfTime)
+        {
+            return TIMEOUT;
+        }
 
         if (score > alpha)
         {
             alpha = score;
             bestMove = move;
-
-            const bool isCapture = getCaptured(move) != NULL_PIECE;
-            if (isCapture)
+            if constexpr (isPrincipalNode)
             {
-                history[color == -1 ? 0 : 1][getFrom(move)][getTo(move)] += depth * depth;
+                updatePrincipalVariation(stack, move);
             }
+
             if (score >= beta)
             {
-                // a quiet move that caused a beta cutoff is a killer move
-                if (!isCapture)
+                // reward the move that caused the cutoff, and punish the moves searched before it that didn't
+                const int bonus = std::min(HISTORY_BONUS * depth * depth, MAX_HISTORY_BONUS);
+                if (isQuiet)
+                {
+                    // a quiet move that caused a beta cutoff is a killer move
+                    if (stack->killerMoves[0] != move)
+                    {
+                        stack->killerMoves[1] = stack->killerMoves[0];
+                        stack->killerMoves[0] = move;
+                    }
+                    if (counterMove)
+                    {
+                        *counterMove = move;
+                    }
+
+                    updateQuietHistory(stack, move, isWhite, bonus);
+                    for (int i = 0; i < numQuietsSearched; i++)
+                    {
+                        updateQuietHistory(stack, quietsSearched[i], isWhite, -bonus);
+                    }
+                }
+                else
+                {
+                    updateHistory(captureHistory[getMoved(move)][getTo(move)][getCaptured(move)], bonus);
+                }
+                for (int i = 0; i < numCapturesSearched; i++)
                 {
-                    killerMoves[depth][1] = killerMoves[depth][0];
-                    killerMoves[depth][0] = move;
+                    const Move capture = capturesSearched[i];
+                    updateHistory(captureHistory[getMoved(capture)][getTo(capture)][getCaptured(capture)], -bonus);
                 }
+                transpositions.store(
+                    position.hash,
+                    move,
+                    scoreToTransposition(beta, ply),
+                    staticEval,
+                    depth,
+                    LOWER_BOUND);
                 return beta;
             }
         }
+        if (isQuiet)
+        {
+            quietsSearched[numQuietsSearched++] = move;
+        }
+        else
+        {
+            capturesSearched[numCapturesSearched++] = move;
+        }
     }
 
-    if (bestMove != NULL_MOVE)
+    if (moveNum == 0)
     {
-        // this node is a principal variation node, so write to the transposition table
-        node.hash = position.hash;
-        node.bestMove = bestMove;
+        if (isInCheck)
+        {
+            // return a checkmate score, and lower the score the farther the checkmate is
+            return MIN_SCORE + ply;
+        }
+        else
+        {
+            // this is a draw by stalemate, so return the contempt factor
+            return CONTEMPT;
+        }
     }
+
+    // if no move raised alpha, we only know an upper bound on this position's score
+    transpositions.store(
+        position.hash,
+        bestMove,
+        scoreToTransposition(alpha, ply),
+        staticEval,
+        depth,
+        bestMove != NULL_MOVE ? EXACT_BOUND : UPPER_BOUND);
     return alpha;
 }
 
-ScoredMove Search::searchByDepth(const int depth)
+void Search::initRootMoves()
+{
+    rootMoves.clear();
+    rootHash = position.hash;
+
+    moveGen.genMoves();
+    for (int i = 0; i < moveGen.numMoves; i++)
+    {
+        rootMoves.push_back(RootMove{moveGen.moveList[i], MIN_SCORE, 0, 0, {}});
+    }
+}
+
+ScoredMove Search::searchByDepth(const int depth, Score alpha, const Score beta)
+{
+    const ScoredMove best = position.isWhiteToMove
+        ? searchRoot<true>(depth, alpha, beta)
+        : searchRoot<false>(depth, alpha, beta);
+    publishNodes();
+    totalNodes += branchNodes + quietNodes;
+    return best;
+}
+
+template<bool isWhite>
+ScoredMove Search::searchRoot(const int depth, Score alpha, const Score beta)
 {
     isOutOfTime = false;
     branchNodes = 0;
     leafNodes = 0;
     quietNodes = 0;
+    reverseFutilityPrunes = 0;
+    futilityPrunes = 0;
+    razoringPrunes = 0;
+    lateMovePrunes = 0;
+    historyPrunes = 0;
+    nullMoveAttempts = 0;
+    nullMoveCutoffs = 0;
+    nullMoveVerifications = 0;
+    iirReductions = 0;
+    checkExtensions = 0;
+    recaptureExtensions = 0;
+    pawnExtensions = 0;
+    selDepth = 0;
+    rootDepth = depth;
 
-    const long startMillis = getEpochMillis();
+    if (rootMoves.empty() || rootHash != position.hash)
+    {
+        initRootMoves();
+    }
+    if (rootMoves.empty())
+    {
+        return ScoredMove{NULL_MOVE, 0};
+    }
 
-    Score bestScore = MIN_SCORE;
-    std::vector<Move> bestMoves;
+    const long startMillis = getMonotonicMillis();
+    const Score alphaBefore = alpha;
 
-    moveGen.genMoves();
-    const int numMoves = moveGen.numMoves;
-    Move moves[256];
-    std::memcpy(moves, moveGen.moveList, sizeof moveGen.moveList);
+    // the root moves are still sorted from the last iteration, so the first move is our best guess
+    Score bestScore = MIN_SCORE;
     const Position::Irreversibles state = position.irreversibles;
-    for (int i = 0; i < numMoves; i++)
+    constexpr int color = isWhite ? 1 : -1;
+
+    SearchStack* stack = &searchStack[STACK_OFFSET];
+    stack->ply = 0;
+    stack->extensions = 0;
+    stack->staticEval = evaluator.evaluate() * color;
+    stack->isFollowingPv = true;
+    (stack + 1)->ply = 1;
+    (stack + 1)->extensions = 0;
+    // the moves before pvIndex are the best moves of earlier lines, so leave them out
+    for (int i = pvIndex; i < static_cast<int>(rootMoves.size()); i++)
     {
-        Move move = moves[i];
+        RootMove& rootMove = rootMoves[i];
+        const U64 nodesBefore = branchNodes + quietNodes;
 
-        position.makeMove(move);
-        Score score = -negamax(position.isWhiteToMove ? 1 : -1, depth, false, MIN_SCORE, MAX_SCORE);
-        position.unMakeMove(move, state);
+        setCurrentMove(stack, rootMove.move);
+        position.doMove<isWhite>(rootMove.move);
+        followedPv = &rootMove.pv;
+        (stack + 1)->pvLength = 0;
+        Score score;
+        if (i == pvIndex)
+        {
+            score = -negamax<!isWhite, PRINCIPAL_NODE>(stack + 1, depth, false, -beta, -alpha);
+        }
+        else
+        {
+            // prove every other move is worse than the best one so far with a null window
+            score = -negamax<!isWhite, NON_PRINCIPAL_NODE>(stack + 1, depth, false, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+            {
+                score = -negamax<!isWhite, PRINCIPAL_NODE>(stack + 1, depth, false, -beta, -alpha);
+            }
+        }
+        position.undoMove<isWhite>(rootMove.move, state);
 
         if (isOutOfTime)
         {
             return ScoredMove{NULL_MOVE, TIMEOUT};
         }
-        else if (score > bestScore)
+
+        rootMove.nodes = branchNodes + quietNodes - nodesBefore;
+        bestScore = std::max(bestScore, score);
+        if (score > alpha)
         {
-            bestMoves.clear();
-            bestMoves.push_back(move);
-            bestScore = score;
+            // only moves that raised alpha have a real score and line, the rest are just known to be worse
+            rootMove.score = score;
+            rootMove.pv.assign(1, rootMove.move);
+            rootMove.pv.insert(rootMove.pv.end(), (stack + 1)->pv, (stack + 1)->pv + (stack + 1)->pvLength);
+            alpha = score;
+            // move the new best move to the front, and keep the order of the rest
+            std::rotate(rootMoves.begin() + pvIndex, rootMoves.begin() + i, rootMoves.begin() + i + 1);
+            if (score >= beta)
+            {
+                break;
+            }
         }
-        else if (score == bestScore)
+        else
         {
-            bestMoves.push_back(move);
+            rootMove.score = MIN_SCORE;
         }
     }
-    // add some variance when choosing between equal moves
-    ScoredMove bestMove = ScoredMove{bestMoves[rand() % bestMoves.size()], bestScore};
 
-    const Hash key = position.hash % 1048583;
-    Node& node = transpositionTable[key];
-    node.bestMove = bestMove.move;
-    node.hash = position.hash;
+    // order the moves we searched after the best one by score, and then by how much effort they took to refute
+    std::stable_sort(rootMoves.begin() + pvIndex + 1, rootMoves.end(), [](const RootMove& a, const RootMove& b)
+    {
+        return a.score != b.score ? a.score > b.score : a.nodes > b.nodes;
+    });
+    ScoredMove bestMove = ScoredMove{rootMoves[pvIndex].move, bestScore};
+    rootMoves[pvIndex].selDepth = selDepth;
 
-    printSearchInfo(getEpochMillis() - startMillis, depth, bestMove);
+    const bool isFailLow = bestMove.score <= alphaBefore;
+    const bool isFailHigh = bestMove.score >= beta;
+
+    // later lines are worse than the best move, and must not replace it in the table
+    if (pvIndex == 0)
+    {
+        transpositions.store(
+            position.hash,
+            bestMove.move,
+            scoreToTransposition(bestMove.score, 0),
+            evaluator.evaluate() * color,
+            depth + 1,
+            isFailLow ? UPPER_BOUND : isFailHigh ? LOWER_BOUND : EXACT_BOUND);
+    }
+
+    if (!isHelper && pvIndex == 0)
+    {
+        if (isFailLow || isFailHigh)
+        {
+            printAspirationFail(depth, isFailHigh, alphaBefore, beta);
+        }
+        else
+        {
+            printSearchInfo(getMonotonicMillis() - startMillis, depth, bestMove);
+        }
+    }
 
     return bestMove;
 }
 
+void Search::setIirDepth(const int depth)
+{
+    iirDepth = depth;
+}
+
+void Search::setMultiPv(const int numLines)
+{
+    multiPv = numLines;
+}
+
+ScoredMove Search::searchLines(const int depth)
+{
+    // each line starts its aspiration window around its own score from the last iteration
+    const int numLines = std::min<int>(multiPv, static_cast<int>(rootMoves.size()));
+    Score previousScores[MAX_MULTI_PV];
+    for (int line = 0; line < numLines; line++)
+    {
+        previousScores[line] = rootMoves[line].score;
+    }
+
+    ScoredMove best = ScoredMove{NULL_MOVE, TIMEOUT};
+    for (pvIndex = 0; pvIndex < numLines; pvIndex++)
+    {
+        best = searchByAspiration(depth, previousScores[pvIndex]);
+        if (isOutOfTime)
+        {
+            pvIndex = 0;
+            return best;
+        }
+    }
+    pvIndex = 0;
+
+    // a later line can come out better than an earlier one, since each search only bounds the moves after it
+    std::stable_sort(rootMoves.begin(), rootMoves.begin() + numLines, [](const RootMove& a, const RootMove& b)
+    {
+        return a.score > b.score;
+    });
+    if (!isHelper)
+    {
+        printLines(depth, numLines);
+    }
+    return ScoredMove{rootMoves[0].move, rootMoves[0].score};
+}
+
+void Search::setTimeLimit(const int msTargetElapsed)
+{
+    timeManager.setMoveTime(msTargetElapsed);
+}
+
+void Search::setTimeControl(const int msRemaining, const int msIncrement, const int movesToGo)
+{
+    timeManager.setClock(msRemaining, msIncrement, movesToGo);
+}
+
+void Search::clearTimeLimit()
+{
+    timeManager.setInfinite();
+}
+
+void Search::setMoveOverhead(const int msOverhead)
+{
+    timeManager.setMoveOverhead(msOverhead);
+}
+
+double Search::getBestMoveNodeShare() const
+{
+    U64 nodes = 0;
+    for (const RootMove& rootMove : rootMoves)
+    {
+        nodes += rootMove.nodes;
+    }
+    return nodes ? (double)rootMoves[0].nodes / (double)nodes : 1.0;
+}
+
+ScoredMove Search::searchByAspiration(const int depth, const Score previousScore)
+{
+    // mate scores jump around too much between iterations to guess a window for them
+    if (depth < 4 || std::abs(previousScore) >= MIN_MATE_SCORE)
+    {
+        return searchByDepth(depth);
+    }
+
+    // guess that this iteration will score close to the last one.
+    // if it doesn't, search again with a window twice as wide around the score we got
+    Score window = ASPIRATION_WINDOW;
+    Score alpha = std::max(previousScore - window, MIN_SCORE);
+    Score beta = std::min(previousScore + window, MAX_SCORE);
+    while (true)
+    {
+        const ScoredMove best = searchByDepth(depth, alpha, beta);
+        if (isOutOfTime || (best.score > alpha && best.score < beta))
+        {
+            return best;
+        }
+
+        window *= 2;
+        if (best.score <= alpha)
+        {
+            alpha = std::max(best.score - window, MIN_SCORE);
+        }
+        else
+        {
+            beta = std::min(best.score + window, MAX_SCORE);
+        }
+    }
+}
+
 Move Search::searchByTime(const int msTargetElapsed)
 {
-    initHistory();
-    initKillerMoves();
+    setTimeLimit(msTargetElapsed);
+    setSearchLimits(0, 0);
+    return searchUntilStopped();
+}
 
-    long startTime = getEpochMillis();
+void Search::setSearchLimits(const int maxDepth, const U64 maxNodes)
+{
+    depthLimit = maxDepth;
+    nodeLimit = maxNodes;
+}
 
-    moveGen.genMoves();
-    const int numMoves = moveGen.numMoves;
-    if (numMoves == 1)
+Move Search::searchUntilStopped()
+{
+    // the watchdog stops the search at the hard limit, no matter where it is in the tree
+    timeManager.startWatchdog(isStopped);
+    const Move best = searchIteratively();
+    timeManager.stopWatchdog();
+
+    if (timeManager.getHardTime() >= 0)
+    {
+        printSearchTime();
+    }
+    std::cout << "info string | Total nodes: " << totalNodes << "\n";
+    return best;
+}
+
+Move Search::searchIteratively()
+{
+    totalNodes = 0;
+    ponderMove = NULL_MOVE;
+    initHistory();
+    initSearchStack();
+    initRootMoves();
+
+    if (rootMoves.empty())
     {
-        printSearchTime(msTargetElapsed, startTime);
-        return moveGen.moveList[0];
+        return NULL_MOVE;
+    }
+    if (rootMoves.size() == 1)
+    {
+        return rootMoves[0].move;
     }
 
-    // start off by searching to a depth of 1 without a time restriction.
-    // therefore, we will always have a move to fall back on
-    endTime = LLONG_MAX;
-    ScoredMove best = searchByDepth(1);
+    // the first iteration ignores the clock, so we will always have a move to fall back on
+    timeManager.startSearch();
+    ScoredMove best = searchLines(1);
+    timeManager.update(best.move, best.score, getBestMoveNodeShare());
+    ponderMove = rootMoves[0].pv.size() > 1 ? rootMoves[0].pv[1] : NULL_MOVE;
 
-    endTime = startTime + msTargetElapsed;
-    long lastSearchTime = 0;
-    for (int depth = 2; depth < MAX_DEPTH; ++depth)
+    const int maxDepth = depthLimit ? std::min(depthLimit, MAX_DEPTH - 1) : MAX_DEPTH - 1;
+    for (int depth = 2; depth <= maxDepth; ++depth)
     {
-        // if we estimate the next search will take too much time
-        if (endTime < getEpochMillis() + 7 * lastSearchTime)
+        // the limits are read fresh every iteration, because a ponderhit can change them
+        if (timeManager.isSoftLimitReached() || (nodeLimit && totalNodes >= nodeLimit))
         {
             break;
         }
 
-        long searchStartTime = getEpochMillis();
-        const ScoredMove bestForDepth = searchByDepth(depth);
+        const ScoredMove bestForDepth = searchLines(depth);
 
         if (isOutOfTime)
         {
             break;
         }
+        // the first root move only replaces the best move once its iteration is complete
+        ponderMove = rootMoves[0].pv.size() > 1 ? rootMoves[0].pv[1] : NULL_MOVE;
+
         // if we found a mating line while searching
-        if (bestForDepth.score >= MAX_SCORE - MAX_DEPTH)
+        if (bestForDepth.score >= MIN_MATE_SCORE)
         {
             return bestForDepth.move;
         }
 
-        lastSearchTime = getEpochMillis() - searchStartTime;
+        timeManager.update(bestForDepth.move, bestForDepth.score, getBestMoveNodeShare());
         best = bestForDepth;
     }
 
-    printSearchTime(msTargetElapsed, startTime);
     return best.move;
 }
 
-Move Search::searchByTimeControl(const int msRemaining, const int msIncrement)
+Move Search::searchToDepth(const int maxDepth)
+{
+    // nothing else is searching, so a stop left over from an earlier search can't be meant for us
+    isStopped = false;
+    clearTimeLimit();
+    setSearchLimits(maxDepth, 0);
+    return searchIteratively();
+}
+
+void Search::searchAsHelper(const int helperId)
 {
-    int estimatedRemaining = msRemaining + msIncrement * 19;
-    int msSearch = estimatedRemaining / 20;
+    isHelper = true;
+    totalNodes = 0;
+    publishedNodes = 0;
+    initHistory();
+    initSearchStack();
+    initRootMoves();
 
-    return searchByTime(msSearch);
+    // helpers keep searching deeper until the main thread tells them to stop.
+    // half of them skip a depth, so the threads don't all search the same tree in lockstep
+    clearTimeLimit();
+    Score score = 0;
+    for (int depth = 1 + helperId % 2; depth < MAX_DEPTH; depth++)
+    {
+        if (isStopped.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+        score = searchByAspiration(depth, score).score;
+        if (isOutOfTime)
+        {
+            break;
+        }
+    }
+}
+
+U64 Search::getTotalNodes() const
+{
+    return totalNodes;
+}
+
+void Search::setHelperNodes(std::atomic<U64>* nodes)
+{
+    helperNodes = nodes;
+}
+
+Move Search::getPonderMove() const
+{
+    return ponderMove;
 }
 
 void Search::printSearchInfo(
@@ -424,6 +1234,7 @@ void Search::printSearchInfo(
     std::cout << std::left;
 
     std::cout << "info string | Depth: " << std::setw(2) << depth;
+    std::cout << std::setw(12) << "| Sel depth: " << std::setw(3) << selDepth;
     std::cout << std::setw(7) << "| Time: " << std::setw(10) << elapsed;
     std::cout << std::setw(8) << "| Score: " << std::setw(6) << bestMove.score;
     std::cout << std::setw(7) << "| Move: " << std::setw(6) << moveToStr(bestMove.move);
@@ -432,28 +1243,76 @@ void Search::printSearchInfo(
     std::cout << std::setw(13) << "| Leaf nodes: " << std::setw(10) << leafNodes;
     std::cout << std::setw(7) << "| kN/S: " << std::setw(6) << kNodesPerSec;
     std::cout << std::setw(6) << "| ABF: " << std::setw(10) << branchingFactor << "\n";
+    std::cout << "info string | Pruned nodes | Reverse futility: " << reverseFutilityPrunes;
+    std::cout << " | Futility: " << futilityPrunes;
+    std::cout << " | Razoring: " << razoringPrunes;
+    std::cout << " | Late move: " << lateMovePrunes;
+    std::cout << " | History: " << historyPrunes << "\n";
+    std::cout << "info string | Null moves | Tried: " << nullMoveAttempts;
+    std::cout << " | Cut off: " << nullMoveCutoffs;
+    std::cout << " | Verified: " << nullMoveVerifications << "\n";
+    std::cout << "info string | Extensions | Check: " << checkExtensions;
+    std::cout << " | Recapture: " << recaptureExtensions;
+    std::cout << " | Pawn push: " << pawnExtensions << "\n";
+    std::cout << "info string | Reductions | Internal iterative: " << iirReductions << "\n";
     std::cout << "info string | Principal variation: ";
-    printPrincipalVariation(position.hash, depth + 1);
+    for (const Move move : rootMoves[0].pv)
+    {
+        std::cout << moveToStr(move) << ", ";
+    }
     std::cout << "\n";
 
 }
 
-void Search::printSearchTime(
-        const long msTargetElapsed,
-        const long startTime)
+void Search::printLines(const int depth, const int numLines)
+{
+    const long msElapsed = getMonotonicMillis() - timeManager.getStartTime();
+    const U64 nodes = totalNodes + (helperNodes ? helperNodes->load(std::memory_order_relaxed) : 0);
+    for (int line = 0; line < numLines; line++)
+    {
+        const RootMove& rootMove = rootMoves[line];
+
+        // mate scores are given in moves, not plies
+        std::string score = "cp " + std::to_string(rootMove.score);
+        if (std::abs(rootMove.score) >= MIN_MATE_SCORE)
+        {
+            const int matePlies = MAX_SCORE - std::abs(rootMove.score);
+            score = "mate " + std::to_string((rootMove.score > 0 ? 1 : -1) * (matePlies + 1) / 2);
+        }
+
+        std::cout << "info depth " << depth;
+        std::cout << " seldepth " << rootMove.selDepth;
+        std::cout << " multipv " << line + 1;
+        std::cout << " score " << score;
+        std::cout << " nodes " << nodes;
+        std::cout << " nps " << (msElapsed ? nodes * 1000 / msElapsed : 0);
+        std::cout << " time " << msElapsed;
+        std::cout << " pv";
+        for (const Move move : rootMove.pv)
+        {
+            std::cout << " " << moveToStr(move);
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+}
+
+void Search::printAspirationFail(
+        const int depth,
+        const bool isFailHigh,
+        const Score alpha,
+        const Score beta)
 {
-    std::cout << "info string Target elapsed: " << msTargetElapsed << ", Actual elapsed: " << getEpochMillis() - startTime << "\n";
+    std::cout << "info string | Depth: " << std::setw(2) << depth;
+    std::cout << " | Aspiration window [" << alpha << ", " << beta << "] failed ";
+    std::cout << (isFailHigh ? "high" : "low") << ", searching again\n";
 }
 
-void Search::printPrincipalVariation(const Hash zobristHash, const int depth)
+void Search::printSearchTime()
 {
-    Node node = transpositionTable[zobristHash % TRANSPOSITION_TABLE_SIZE];
-    if (node.hash == zobristHash && depth)
-    {
-        std::cout << moveToStr(node.bestMove) << ", ";
-        const Position::Irreversibles state = position.irreversibles;
-        position.makeMove(node.bestMove);
-        printPrincipalVariation(position.hash, depth - 1);
-        position.unMakeMove(node.bestMove, state);
-    }
-}
\ No newline at end of file
+    std::cout << "info string | Time | Soft limit: " << timeManager.getSoftTime() << "ms";
+    std::cout << " | Hard limit: " << timeManager.getHardTime() << "ms";
+    std::cout << " | Elapsed: " << getMonotonicMillis() - timeManager.getStartTime() << "ms";
+    std::cout << " | Overshoot: " << timeManager.getOvershoot() << "ms";
+    std::cout << " | Worst overshoot: " << timeManager.getWorstOvershoot() << "ms\n";
+}
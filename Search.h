@@ -5,76 +5,291 @@
 #ifndef KARL_SEARCH_H
 #define KARL_SEARCH_H
 
+#include <atomic>
 #include "Eval.h"
 #include "MoveGen.h"
+#include "MovePicker.h"
+#include "TimeManager.h"
+#include "Transposition.h"
 
 inline constexpr int MAX_DEPTH = 64;
 
+// any score beyond this bound is a forced checkmate
+inline constexpr Score MIN_MATE_SCORE = MAX_SCORE - MAX_DEPTH;
+
 struct ScoredMove
 {
     Move move;
     Score score;
 };
 
+struct RootMove
+{
+    Move move;
+    Score score;
+    U64 nodes;
+
+    // the deepest ply reached while searching the line of this move
+    int selDepth;
+
+    // the line we expect to be played after this move, starting with the move itself
+    std::vector<Move> pv;
+};
+
+// principal nodes are searched with a full window, and every other node with a null window.
+// the root is searched by searchByDepth
+enum NodeType
+{
+    PRINCIPAL_NODE,
+    NON_PRINCIPAL_NODE
+};
+
+// the state of one node on the path from the root to the node being searched
+struct SearchStack
+{
+    int ply;
+
+    // how many plies were added to the search on the path to this node
+    int extensions;
+
+    Score staticEval;
+    Move currentMove;
+    Move killerMoves[2];
+
+    // the continuation history entry for the current move, so the next two plies can look it up
+    PieceToHistory* continuationHistory;
+
+    // if our static evaluation is better than it was two plies ago
+    bool isImproving;
+
+    // the best line found from this node, filled in by principal nodes when a move raises alpha.
+    // each ply copies the line of the ply after it, so together they make a triangular table
+    Move pv[MAX_DEPTH + 1];
+    int pvLength;
+
+    // if every move on the path to this node follows the line the root move had in the last iteration
+    bool isFollowingPv;
+};
+
 class Search
 {
 public:
-    Search(Position& position, MoveGen& moveGen, Evaluator& evaluator);
+    Search(
+        Position& position,
+        MoveGen& moveGen,
+        Evaluator& evaluator,
+        TranspositionTable& transpositions,
+        std::atomic<bool>& isStopped);
 
-    ScoredMove searchByDepth(const int depth);
+    ScoredMove searchByDepth(
+        const int depth,
+        Score alpha = MIN_SCORE,
+        const Score beta = MAX_SCORE);
     Move searchByTime(const int msTargetElapsed);
-    Move searchByTimeControl(const int msRemaining, const int msIncrement);
+    Move searchUntilStopped();
+
+    // iterative deepening to a fixed depth, ignoring the clock
+    Move searchToDepth(const int maxDepth);
+
+    // stop deepening after this depth, and stop searching after this many nodes. 0 means no limit.
+    // with one thread, a node limit always gives the same move and node count
+    void setSearchLimits(const int maxDepth, const U64 maxNodes);
+    void searchAsHelper(const int helperId);
+
+    // 0 turns internal iterative reduction off
+    static constexpr int DEFAULT_IIR_DEPTH = 4;
+    void setIirDepth(const int depth);
+
+    // how many of the best root moves to search and report with their own scores
+    static constexpr int MAX_MULTI_PV = 64;
+    void setMultiPv(const int numLines);
+
+    // these may be called from another thread while a search is running
+    void setTimeLimit(const int msTargetElapsed);
+    void setTimeControl(const int msRemaining, const int msIncrement, const int movesToGo);
+    void clearTimeLimit();
+    void setMoveOverhead(const int msOverhead);
+
+    // the nodes searched since the last search started, over every iteration
+    U64 getTotalNodes() const;
+
+    // helpers add their nodes to this counter after every search of the root, and the main thread reports the sum
+    void setHelperNodes(std::atomic<U64>* nodes);
+
+    // the reply we expect to the move the last search returned, or NULL_MOVE if we don't know it
+    Move getPonderMove() const;
 
 private:
     Evaluator& evaluator;
     Position& position;
     MoveGen& moveGen;
+    TranspositionTable& transpositions;
+
+    // shared by every thread searching the same position
+    std::atomic<bool>& isStopped;
+    bool isHelper;
+
+    int depthLimit;
+    U64 nodeLimit;
+
+    // while searching the line of one root move, the root moves before it are the best moves of the earlier lines
+    int multiPv;
+    int pvIndex;
+    ScoredMove searchLines(const int depth);
 
     Score captureScores[13][13];
-    Move killerMoves[MAX_DEPTH][2];
-    int history[2][64][64];
+    int reductions[MAX_DEPTH][256];
+    // every history score is kept between -MAX_HISTORY and MAX_HISTORY
+    static constexpr int MAX_HISTORY = 16384;
+    static constexpr int HISTORY_BONUS = 32;
+    static constexpr int MAX_HISTORY_BONUS = 2048;
+
+    ButterflyHistory history[2];
+    CaptureHistory captureHistory;
+
+    // the quiet move that last refuted a move, indexed by the piece that moved and where it moved to
+    Move counterMoves[13][64];
+
+    // a piece to history table for every piece and square the previous move could have been.
+    // the first table belongs to no move, and stays empty
+    std::unique_ptr<PieceToHistory[]> continuationHistory;
 
     inline void initHistory();
-    inline void initKillerMoves();
+    inline void initSearchStack();
     inline void initCaptureScores();
-    inline void initTranspositions();
+    inline void initReductions();
+    void initRootMoves();
+
+    // the root is searched with a few empty entries before it, so nodes near the root can look back two plies
+    // and forward two plies without checking
+    static constexpr int STACK_OFFSET = 2;
+    static constexpr Score NO_EVAL = MIN_SCORE - 1;
+    SearchStack searchStack[STACK_OFFSET + MAX_DEPTH + 3];
+
+    // the legal moves in the root position, sorted by how good they were in the last iteration
+    std::vector<RootMove> rootMoves;
+    Hash rootHash;
+
+    // the line of the root move being searched, from the last iteration. principal nodes along it try its move first
+    const std::vector<Move>* followedPv;
+    Move ponderMove;
+
+    static inline Score scoreToTransposition(const Score score, const int ply);
+    static inline Score scoreFromTransposition(const Score score, const int ply);
+
+    inline bool shouldStop();
+    inline void publishNodes();
+    static constexpr Score ASPIRATION_WINDOW = 25;
+    ScoredMove searchByAspiration(const int depth, const Score previousScore);
+    Move searchIteratively();
 
-    Score quiescence(Score alpha, const Score beta, const int color);
+    // every search below the root knows whose turn it is at compile time, and flips it on each ply
+    template<bool isWhite>
+    ScoredMove searchRoot(const int depth, Score alpha, const Score beta);
+
+    // forward pruning margins are in centipawns per ply of remaining depth
+    static constexpr int REVERSE_FUTILITY_DEPTH = 6;
+    static constexpr Score REVERSE_FUTILITY_MARGIN = 80;
+    static constexpr int FUTILITY_DEPTH = 2;
+    static constexpr Score FUTILITY_MARGIN = 150;
+    static constexpr int RAZORING_DEPTH = 2;
+    static constexpr Score RAZORING_MARGIN = 300;
+    static constexpr int LATE_MOVE_PRUNING_DEPTH = 3;
+    static constexpr int LATE_MOVE_PRUNING_BASE = 3;
+    // history margins are in history points per ply of remaining depth
+    static constexpr int HISTORY_PRUNING_DEPTH = 5;
+    static constexpr int HISTORY_PRUNING_MARGIN = 1024;
+    static constexpr int NULL_MOVE_DEPTH = 3;
+    static constexpr int NULL_MOVE_REDUCTION = 3;
+    static constexpr int NULL_MOVE_VERIFICATION_DEPTH = 10;
+
+    // nodes at least this deep with no move from the transposition table are searched one ply shallower
+    int iirDepth;
+
+    // a path can be extended by at most this fraction of the root depth, so checks can't go on forever
+    static constexpr int EXTENSION_BUDGET_DIVISOR = 2;
+
+    // captures that can't bring the score within this margin of alpha are not searched in quiescence
+    static constexpr Score DELTA_MARGIN = 200;
+    template<bool isWhite>
+    Score quiescence(SearchStack* stack, Score alpha, const Score beta);
+    template<bool isWhite, NodeType nodeType>
     Score negamax(
-        const int color,
-        const int depth,
+        SearchStack* stack,
+        int depth,
         const bool isNull,
         Score alpha,
         Score beta);
 
-    template<bool isQuiescent>
-    void orderMove(
-        Move moves[256],
-        const int numMoves,
+    template<bool isWhite>
+    inline int getReduction(
+        const SearchStack* stack,
+        const Move move,
         const int moveNum,
         const int depth,
-        const int color,
-        const Move principalMove);
+        const bool isInCheck,
+        const bool isPrincipalNode);
+
+    template<bool isWhite>
+    inline int getExtension(
+        const SearchStack* stack,
+        const Move move,
+        const bool isPrincipalNode);
 
     inline bool isRepetition();
 
+    static inline void updateHistory(int& score, const int bonus);
+    inline int getQuietHistory(const SearchStack* stack, const Move move, const bool isWhite);
+    void updateQuietHistory(const SearchStack* stack, const Move move, const bool isWhite, const int bonus);
+    inline void setCurrentMove(SearchStack* stack, const Move move);
+    static inline void updatePrincipalVariation(SearchStack* stack, const Move move);
+    inline void prefetch();
+
     void printSearchInfo(
             const long msElapsed,
             const int depth,
             const ScoredMove& bestMove);
 
-    void printPrincipalVariation(const Hash zobristHash, const int depth);
+    void printAspirationFail(
+            const int depth,
+            const bool isFailHigh,
+            const Score alpha,
+            const Score beta);
+
+    void printLines(const int depth, const int numLines);
 
-    void printSearchTime(
-            const long msTargetElapsed,
-            const long startTime);
+    void printSearchTime();
 
     U64 branchNodes;
     U64 quietNodes;
     U64 leafNodes;
+    U64 totalNodes;
+    std::atomic<U64>* helperNodes;
+    U64 publishedNodes;
+
+    U64 reverseFutilityPrunes;
+    U64 futilityPrunes;
+    U64 razoringPrunes;
+    U64 lateMovePrunes;
+    U64 historyPrunes;
+    U64 nullMoveAttempts;
+    U64 nullMoveCutoffs;
+    U64 nullMoveVerifications;
+    U64 iirReductions;
+    U64 checkExtensions;
+    U64 recaptureExtensions;
+    U64 pawnExtensions;
 
-    long endTime;
+    // the deepest ply any line reached, including the quiescence search
+    int selDepth;
+
+    TimeManager timeManager;
+
+    // the fraction of the last iteration's root nodes that were spent on the best move
+    double getBestMoveNodeShare() const;
     bool isOutOfTime;
+
+    int rootDepth;
 };
 
 #endif //KARL_SEARCH_H
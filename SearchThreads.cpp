@@ -0,0 +1,84 @@
+#include "SearchThreads.h"
+
+SearchThreads::Helper::Helper(
+    const Position& root,
+    const Magics& magics,
+    TranspositionTable& transpositions,
+    std::atomic<bool>& isStopped)
+: position(root),
+  moveGen(position, magics),
+  evaluator(position, moveGen),
+  search(position, moveGen, evaluator, transpositions, isStopped)
+{
+}
+
+SearchThreads::SearchThreads(
+    const Position& root,
+    const Magics& magics,
+    TranspositionTable& transpositions,
+    std::atomic<bool>& isStopped)
+: root(root), magics(magics), transpositions(transpositions), isStopped(isStopped)
+{
+    iirDepth = Search::DEFAULT_IIR_DEPTH;
+    helperNodes = 0;
+}
+
+SearchThreads::~SearchThreads()
+{
+    stopHelpers();
+}
+
+void SearchThreads::setNumThreads(const int numThreads)
+{
+    stopHelpers();
+    helpers.clear();
+    // the main thread counts as one of the threads
+    for (int i = 1; i < numThreads; i++)
+    {
+        helpers.push_back(std::make_unique<Helper>(root, magics, transpositions, isStopped));
+        helpers.back()->search.setIirDepth(iirDepth);
+        helpers.back()->search.setHelperNodes(&helperNodes);
+    }
+}
+
+void SearchThreads::setIirDepth(const int depth)
+{
+    iirDepth = depth;
+    for (const std::unique_ptr<Helper>& helper : helpers)
+    {
+        helper->search.setIirDepth(depth);
+    }
+}
+
+std::atomic<U64>& SearchThreads::getHelperNodes()
+{
+    return helperNodes;
+}
+
+void SearchThreads::startHelpers()
+{
+    isStopped = false;
+    helperNodes = 0;
+    for (size_t helperId = 0; helperId < helpers.size(); helperId++)
+    {
+        Helper& helper = *helpers[helperId];
+        helper.position = root;
+        helper.thread = std::thread([&helper, helperId]()
+        {
+            helper.search.searchAsHelper(helperId);
+        });
+    }
+}
+
+void SearchThreads::stopHelpers()
+{
+    isStopped = true;
+    for (const std::unique_ptr<Helper>& helper : helpers)
+    {
+        if (helper->thread.joinable())
+        {
+            helper->thread.join();
+        }
+    }
+    isStopped = false;
+}
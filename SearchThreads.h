@@ -0,0 +1,64 @@
+#ifndef KARL_SEARCHTHREADS_H
+#define KARL_SEARCHTHREADS_H
+
+#include <memory>
+#include <thread>
+#include "Search.h"
+
+/*
+ * Helper threads for a lazy SMP search.
+ * Every helper searches its own copy of the root position with its own move generator,
+ * evaluator and search, and the only thing they share with the main thread is the
+ * transposition table. The main thread owns the clock and the final best move
+ */
+class SearchThreads
+{
+public:
+    SearchThreads(
+        const Position& root,
+        const Magics& magics,
+        TranspositionTable& transpositions,
+        std::atomic<bool>& isStopped);
+    ~SearchThreads();
+
+    static constexpr int MAX_THREADS = 256;
+
+    void setNumThreads(const int numThreads);
+
+    // the nodes every helper has searched since the helpers were started
+    std::atomic<U64>& getHelperNodes();
+
+    // search options have to be passed on to every helper
+    void setIirDepth(const int depth);
+
+    void startHelpers();
+    void stopHelpers();
+
+private:
+    struct Helper
+    {
+        Helper(
+            const Position& root,
+            const Magics& magics,
+            TranspositionTable& transpositions,
+            std::atomic<bool>& isStopped);
+
+        Position position;
+        MoveGen moveGen;
+        Evaluator evaluator;
+        Search search;
+        std::thread thread;
+    };
+
+    const Position& root;
+    const Magics& magics;
+    TranspositionTable& transpositions;
+    std::atomic<bool>& isStopped;
+    int iirDepth;
+    std::atomic<U64> helperNodes;
+
+    std::vector<std::unique_ptr<Helper>> helpers;
+};
+
+
+#endif //KARL_SEARCHTHREADS_H
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <climits>
+#include "TimeManager.h"
+
+TimeManager::TimeManager()
+{
+    msOverhead = DEFAULT_MOVE_OVERHEAD;
+    startTime = 0;
+    softEndTime = LONG_MAX;
+    hardEndTime = LONG_MAX;
+    isAdjustable = false;
+    isWatching = false;
+    overshoot = 0;
+    worstOvershoot = 0;
+    startSearch();
+}
+
+TimeManager::~TimeManager()
+{
+    stopWatchdog();
+}
+
+void TimeManager::setLimits(const long start, const long msSoft, const long msHard, const bool isAdjustable)
+{
+    {
+        std::lock_guard<std::mutex> lock(watchdogMutex);
+        this->isAdjustable = isAdjustable;
+        startTime = start;
+        softEndTime = msSoft < 0 ? LONG_MAX : start + msSoft;
+        hardEndTime = msHard < 0 ? LONG_MAX : start + msHard;
+    }
+    watchdogSignal.notify_all();
+}
+
+void TimeManager::setMoveOverhead(const int msOverhead)
+{
+    this->msOverhead = msOverhead;
+}
+
+void TimeManager::setMoveTime(const int msMoveTime)
+{
+    const long msAvailable = std::max(msMoveTime - msOverhead, 1);
+    setLimits(getMonotonicMillis(), msAvailable, msAvailable, false);
+}
+
+void TimeManager::setClock(const int msRemaining, const int msIncrement, const int movesToGo)
+{
+    const long msAvailable = std::max(msRemaining - msOverhead, 1);
+    const int movesLeft = movesToGo > 0 ? std::min(movesToGo, DEFAULT_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+
+    // we get the increment back after this move, so we can spend most of it now.
+    // never plan on more than we can afford to lose if the search runs all the way to the hard limit
+    const long msHard = std::min<long>(
+        (msAvailable / movesLeft + msIncrement * 3 / 4) * HARD_LIMIT_RATIO,
+        msAvailable * 3 / 4);
+    const long msSoft = std::min<long>(msAvailable / movesLeft + msIncrement * 3 / 4, msHard);
+
+    setLimits(getMonotonicMillis(), std::max(msSoft, 1L), std::max(msHard, 1L), true);
+}
+
+void TimeManager::setInfinite()
+{
+    setLimits(getMonotonicMillis(), -1, -1, false);
+}
+
+void TimeManager::startSearch()
+{
+    lastBestMove = NULL_MOVE;
+    lastScore = 0;
+    stableIterations = 0;
+    scale = 1.0;
+}
+
+void TimeManager::update(const Move bestMove, const Score score, const double bestMoveNodeShare)
+{
+    // the longer the best move has survived, the less likely another iteration will change it
+    stableIterations = bestMove == lastBestMove ? stableIterations + 1 : 0;
+    const double stabilityScale = std::max(0.7, 1.3 - 0.1 * stableIterations);
+
+    // when the score drops, we might be walking into trouble, so take a closer look
+    const Score scoreDrop = lastBestMove == NULL_MOVE ? 0 : std::clamp(lastScore - score, 0, 150);
+    const double scoreDropScale = 1.0 + scoreDrop / 150.0;
+
+    // a best move that took most of the nodes had to refute a lot of alternatives, so it is probably right
+    const double nodeShareScale = 1.6 - std::clamp(bestMoveNodeShare, 0.0, 1.0);
+
+    scale = std::clamp(stabilityScale * scoreDropScale * nodeShareScale, MIN_SCALE, MAX_SCALE);
+    lastBestMove = bestMove;
+    lastScore = score;
+}
+
+bool TimeManager::isSoftLimitReached() const
+{
+    const long now = getMonotonicMillis();
+    if (!isAdjustable)
+    {
+        return now >= softEndTime;
+    }
+    const long msSoft = softEndTime - startTime;
+    return now >= std::min<long>(startTime + static_cast<long>(msSoft * scale), hardEndTime);
+}
+
+void TimeManager::startWatchdog(std::atomic<bool>& isStopped)
+{
+    stopWatchdog();
+    isWatching = true;
+    overshoot = 0;
+    watchdog = std::thread([this, &isStopped]()
+    {
+        std::unique_lock<std::mutex> lock(watchdogMutex);
+        while (isWatching)
+        {
+            // sleep until the deadline, or until someone changes it or stops us
+            const long deadline = hardEndTime;
+            if (deadline == LONG_MAX)
+            {
+                watchdogSignal.wait(lock);
+            }
+            else if (getMonotonicMillis() >= deadline)
+            {
+                isStopped = true;
+                return;
+            }
+            else
+            {
+                const auto wakeTime = std::chrono::steady_clock::time_point(std::chrono::milliseconds(deadline));
+                watchdogSignal.wait_until(lock, wakeTime);
+            }
+        }
+    });
+}
+
+void TimeManager::stopWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(watchdogMutex);
+        if (!isWatching)
+        {
+            return;
+        }
+        isWatching = false;
+    }
+    watchdogSignal.notify_all();
+    watchdog.join();
+
+    if (hardEndTime != LONG_MAX)
+    {
+        overshoot = std::max(getMonotonicMillis() - hardEndTime, 0L);
+        worstOvershoot = std::max(worstOvershoot, overshoot);
+    }
+}
+
+long TimeManager::getStartTime() const
+{
+    return startTime;
+}
+
+long TimeManager::getSoftTime() const
+{
+    return softEndTime == LONG_MAX ? -1 : softEndTime - startTime;
+}
+
+long TimeManager::getHardTime() const
+{
+    return hardEndTime == LONG_MAX ? -1 : hardEndTime - startTime;
+}
+
+long TimeManager::getOvershoot() const
+{
+    return overshoot;
+}
+
+long TimeManager::getWorstOvershoot() const
+{
+    return worstOvershoot;
+}
@@ -0,0 +1,100 @@
+#ifndef KARL_TIMEMANAGER_H
+#define KARL_TIMEMANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Eval.h"
+#include "Moves.h"
+
+/*
+ * Decides how long one search may take.
+ *
+ * the soft limit is how long we would like to think. once an iteration finishes past it, we stop deepening.
+ * it is stretched when the best move keeps changing, the score drops, or the best move needed few of the root nodes,
+ * and shrunk when the best move is stable and took most of the nodes.
+ * the hard limit is a deadline the search will abort at, even in the middle of an iteration.
+ * a watchdog thread sleeps until the hard limit and raises the stop flag, so the search only has to poll the flag.
+ *
+ * the limits may be set from another thread while a search is running, like when a ponderhit arrives
+ */
+class TimeManager
+{
+public:
+    TimeManager();
+    ~TimeManager();
+
+    // the time we lose to communication with the GUI on every move, taken off the clock before anything else
+    static constexpr int DEFAULT_MOVE_OVERHEAD = 30;
+    static constexpr int MAX_MOVE_OVERHEAD = 5000;
+    void setMoveOverhead(const int msOverhead);
+
+    // search until the time runs out, with no adjustments
+    void setMoveTime(const int msMoveTime);
+
+    // split our remaining time up between the moves left until the next time control.
+    // a movesToGo of 0 means the rest of the game has to be played with what is left
+    void setClock(const int msRemaining, const int msIncrement, const int movesToGo);
+
+    // search until we are told to stop
+    void setInfinite();
+
+    // forget what happened in the last search
+    void startSearch();
+
+    // tell the time manager how the last iteration went, to adjust the soft limit
+    void update(const Move bestMove, const Score score, const double bestMoveNodeShare);
+
+    bool isSoftLimitReached() const;
+
+    // raise the stop flag when the hard limit passes, until the watchdog is stopped
+    void startWatchdog(std::atomic<bool>& isStopped);
+
+    // stop the watchdog, and measure how late we were if we ran into the hard limit
+    void stopWatchdog();
+
+    long getStartTime() const;
+    long getSoftTime() const;
+    long getHardTime() const;
+    long getOvershoot() const;
+    long getWorstOvershoot() const;
+
+private:
+    // without movestogo, plan as if the game will last this many more moves
+    static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+    // the hard limit is this many times the soft limit, as long as it doesn't use up too much of the clock
+    static constexpr int HARD_LIMIT_RATIO = 3;
+
+    // the soft limit is never scaled further than this
+    static constexpr double MIN_SCALE = 0.4;
+    static constexpr double MAX_SCALE = 2.5;
+
+    int msOverhead;
+
+    std::atomic<long> startTime;
+    std::atomic<long> softEndTime;
+    std::atomic<long> hardEndTime;
+    std::atomic<bool> isAdjustable;
+
+    // the limits are changed under the mutex, so the watchdog can't miss a new deadline
+    void setLimits(const long start, const long msSoft, const long msHard, const bool isAdjustable);
+
+    std::thread watchdog;
+    std::mutex watchdogMutex;
+    std::condition_variable watchdogSignal;
+    bool isWatching;
+
+    long overshoot;
+    long worstOvershoot;
+
+    // only read and written by the search thread
+    Move lastBestMove;
+    Score lastScore;
+    int stableIterations;
+    double scale;
+};
+
+
+#endif //KARL_TIMEMANAGER_H
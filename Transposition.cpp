@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "Transposition.h"
+
+TranspositionTable::TranspositionTable()
+{
+    numBuckets = 0;
+    generation = 0;
+    resize(DEFAULT_MEGABYTES);
+}
+
+void TranspositionTable::resize(const size_t megabytes)
+{
+    const size_t newNumBuckets = std::max<size_t>(1, megabytes * 1024 * 1024 / sizeof(Bucket));
+
+    // allocate the new table before freeing the old one, so a failed allocation keeps the old table
+    std::unique_ptr<Bucket[]> newBuckets(new Bucket[newNumBuckets]);
+    buckets = std::move(newBuckets);
+    numBuckets = newNumBuckets;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    // zeroing gigabytes of memory on one core takes a noticeable amount of time, so split it up
+    const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t bucketsPerThread = (numBuckets + numThreads - 1) / numThreads;
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < numThreads; thread++)
+    {
+        const size_t begin = thread * bucketsPerThread;
+        const size_t end = std::min(numBuckets, begin + bucketsPerThread);
+        if (begin >= end)
+        {
+            break;
+        }
+        threads.emplace_back([this, begin, end]()
+        {
+            std::memset(&buckets[begin], 0, (end - begin) * sizeof(Bucket));
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    generation = 0;
+}
+
+void TranspositionTable::age()
+{
+    // the age is stored in six bits, so let it wrap around
+    generation = (generation + 1) & 0x3f;
+}
+
+TranspositionEntry TranspositionTable::load(Slot& slot)
+{
+    const U64 lock = std::atomic_ref<U64>(slot.lock).load(std::memory_order_relaxed);
+    const U64 data = std::atomic_ref<U64>(slot.data).load(std::memory_order_relaxed);
+    const uint32_t meta = lock & 0xffff;
+
+    TranspositionEntry entry{};
+    entry.key = static_cast<uint32_t>(lock >> 32) ^ static_cast<uint32_t>(data) ^ static_cast<uint32_t>(data >> 32) ^ meta;
+    entry.bestMove = static_cast<Move>(data);
+    entry.score = static_cast<int16_t>(data >> 32);
+    entry.staticEval = static_cast<int16_t>(data >> 48);
+    entry.depth = static_cast<int8_t>(meta >> 8);
+    entry.ageAndBound = static_cast<uint8_t>(meta);
+    return entry;
+}
+
+void TranspositionTable::save(Slot& slot, const TranspositionEntry& entry)
+{
+    const U64 data = static_cast<uint32_t>(entry.bestMove)
+        | static_cast<U64>(static_cast<uint16_t>(entry.score)) << 32
+        | static_cast<U64>(static_cast<uint16_t>(entry.staticEval)) << 48;
+    const uint32_t meta = static_cast<uint8_t>(entry.depth) << 8 | entry.ageAndBound;
+    const uint32_t check = entry.key ^ static_cast<uint32_t>(data) ^ static_cast<uint32_t>(data >> 32) ^ meta;
+
+    std::atomic_ref<U64>(slot.data).store(data, std::memory_order_relaxed);
+    std::atomic_ref<U64>(slot.lock).store(static_cast<U64>(check) << 32 | meta, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(const Hash hash, TranspositionEntry& entry)
+{
+    const uint32_t key = getKey(hash);
+    for (Slot& slot : getBucket(hash).slots)
+    {
+        const TranspositionEntry candidate = load(slot);
+        if (candidate.key == key && candidate.getBound() != NO_BOUND)
+        {
+            entry = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(
+    const Hash hash,
+    const Move bestMove,
+    const Score score,
+    const Score staticEval,
+    const int depth,
+    const Bound bound)
+{
+    const uint32_t key = getKey(hash);
+    Bucket& bucket = getBucket(hash);
+
+    // entries that are empty, shallow, or left over from old searches get replaced first
+    const auto getWorth = [this](const TranspositionEntry& entry)
+    {
+        if (entry.getBound() == NO_BOUND)
+        {
+            return INT_MIN;
+        }
+        const int staleness = (generation - entry.getAge()) & 0x3f;
+        return entry.depth - 8 * staleness;
+    };
+
+    Slot* replace = &bucket.slots[0];
+    TranspositionEntry replaced = load(*replace);
+    for (Slot& slot : bucket.slots)
+    {
+        const TranspositionEntry entry = load(slot);
+        if (entry.key == key && entry.getBound() != NO_BOUND)
+        {
+            replace = &slot;
+            replaced = entry;
+            break;
+        }
+        if (getWorth(entry) < getWorth(replaced))
+        {
+            replace = &slot;
+            replaced = entry;
+        }
+    }
+
+    TranspositionEntry entry{};
+    entry.key = key;
+    entry.bestMove = bestMove;
+    entry.score = static_cast<int16_t>(score);
+    entry.staticEval = static_cast<int16_t>(staticEval);
+    entry.depth = static_cast<int8_t>(depth);
+    entry.ageAndBound = generation << 2 | bound;
+
+    if (replaced.key == key && replaced.getBound() != NO_BOUND)
+    {
+        // don't let a shallow bound overwrite a much deeper result for the same position
+        if (bound != EXACT_BOUND && depth < replaced.depth - 2)
+        {
+            replaced.ageAndBound = generation << 2 | replaced.getBound();
+            save(*replace, replaced);
+            return;
+        }
+        // keep the old best move if this search did not find one
+        if (bestMove == NULL_MOVE)
+        {
+            entry.bestMove = replaced.bestMove;
+        }
+    }
+    save(*replace, entry);
+}
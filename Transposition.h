@@ -0,0 +1,131 @@
+#ifndef KARL_TRANSPOSITION_H
+#define KARL_TRANSPOSITION_H
+
+#include <cstdint>
+#include <memory>
+#include "Eval.h"
+#include "Moves.h"
+#include "Zobrist.h"
+
+enum Bound : uint8_t
+{
+    NO_BOUND,
+    UPPER_BOUND,
+    LOWER_BOUND,
+    EXACT_BOUND
+};
+
+/*
+ * The unpacked contents of a transposition table entry.
+ * The low bits of the zobrist hash choose the bucket,
+ * and the high 32 bits are kept in the entry to verify the position
+ */
+struct TranspositionEntry
+{
+    uint32_t key;
+    Move bestMove;
+    int16_t score;
+    int16_t staticEval;
+    int8_t depth;
+    uint8_t ageAndBound;
+
+    Bound getBound() const
+    {
+        return static_cast<Bound>(ageAndBound & 0x3);
+    }
+
+    uint8_t getAge() const
+    {
+        return ageAndBound >> 2;
+    }
+};
+
+class TranspositionTable
+{
+public:
+    TranspositionTable();
+
+    static constexpr int DEFAULT_MEGABYTES = 16;
+    static constexpr int MAX_MEGABYTES = 65536;
+
+    void resize(const size_t megabytes);
+    void clear();
+    void age();
+
+    bool probe(const Hash hash, TranspositionEntry& entry);
+
+    // start loading the bucket of a position we are about to probe, so it is in the cache when we get there
+    void prefetch(const Hash hash) const
+    {
+        __builtin_prefetch(&buckets[getIndex(hash)]);
+    }
+    void store(
+        const Hash hash,
+        const Move bestMove,
+        const Score score,
+        const Score staticEval,
+        const int depth,
+        const Bound bound);
+
+private:
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+
+    /*
+     * An entry is packed into two 64 bit words so that all search threads can share
+     * the table without locks:
+     *
+     * data:
+     * bits 0-31  best move
+     * bits 32-47 score
+     * bits 48-63 static evaluation
+     *
+     * lock:
+     * bits 0-7   age and bound
+     * bits 8-15  depth
+     * bits 32-63 key, xor both halves of data, xor bits 0-15 of lock
+     *
+     * if another thread writes the entry while we are reading it, the words we read
+     * won't belong to the same write, so the key will fail to match
+     */
+    struct Slot
+    {
+        U64 lock;
+        U64 data;
+    };
+
+    // each bucket fills exactly one cache line
+    struct alignas(64) Bucket
+    {
+        Slot slots[ENTRIES_PER_BUCKET];
+    };
+    static_assert(sizeof(Bucket) == 64);
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t numBuckets;
+    uint8_t generation;
+
+    static TranspositionEntry load(Slot& slot);
+    static void save(Slot& slot, const TranspositionEntry& entry);
+
+    static uint32_t getKey(const Hash hash)
+    {
+        return static_cast<uint32_t>(hash >> 32);
+    }
+
+    // map the low 32 bits of the hash onto the table with a multiply and shift instead of a modulo.
+    // the high 32 bits are left alone to verify the position.
+    // this needs every bit of the zobrist keys to be random. a key with bit 31 always clear would only ever
+    // reach the first half of the table, and a key with bit 63 always clear would weaken the verification
+    size_t getIndex(const Hash hash) const
+    {
+        return static_cast<size_t>(((hash & 0xffffffff) * numBuckets) >> 32);
+    }
+
+    Bucket& getBucket(const Hash hash)
+    {
+        return buckets[getIndex(hash)];
+    }
+};
+
+
+#endif //KARL_TRANSPOSITION_H
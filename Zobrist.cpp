@@ -6,15 +6,11 @@
 
 Hash Zobrist::getRandomBits(const int size)
 {
-    const Hash random = static_cast<Hash>(
-            (static_cast<Hash>(rand()))) |
-            (static_cast<Hash>(rand()) << 32);
-
-    return random & (0xffffffffffffffff >> (64 - size));
+    return generator() & (0xffffffffffffffff >> (64 - size));
 }
 
 Zobrist::Zobrist()
-: PIECES{0}, CASTLING{0}, EN_PASSANT{0}
+: PIECES{0}, CASTLING{0}, EN_PASSANT{0}, generator(SEED)
 {
     WHITE_TO_MOVE = getRandomBits(64);
 
@@ -23,7 +19,7 @@ Zobrist::Zobrist()
         CASTLING[castlingFlag] = getRandomBits(64);
     }
 
-    for (int file = A_FILE; file < H_FILE; file++)
+    for (int file = A_FILE; file <= H_FILE; file++)
     {
         EN_PASSANT[file] = getRandomBits(64);
     }
@@ -21,7 +21,12 @@ public:
     Hash WHITE_TO_MOVE;
 
 private:
-    static Hash getRandomBits(const int size);
+    // the keys are the same every time the engine runs, so a search always visits the same nodes.
+    // every bit of a key is random, which the transposition table relies on to index and verify positions
+    static constexpr std::mt19937_64::result_type SEED = 0x4b61726c;
+    std::mt19937_64 generator;
+
+    Hash getRandomBits(const int size);
 
 };
 
@@ -2,7 +2,6 @@
 
 int main()
 {
-    srand(time(nullptr));
     Zobrist zobrist;
     Magics magics;
 